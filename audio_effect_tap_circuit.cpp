@@ -0,0 +1,188 @@
+#include <mutex>
+
+#include "core/object/class_db.h"
+
+#include "audio_effect_tap_circuit.h"
+#include "tap_monitors.h"
+#include "tap_patch_bay.h"
+
+void AudioEffectTapCircuit::_bind_methods() {
+  ClassDB::bind_method(D_METHOD("get_circuit"), &AudioEffectTapCircuit::get_circuit);
+  ClassDB::bind_method(D_METHOD("set_circuit", "circuit"), &AudioEffectTapCircuit::set_circuit);
+  ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "circuit", PROPERTY_HINT_RESOURCE_TYPE, "TapCircuit"), "set_circuit", "get_circuit");
+
+  ClassDB::bind_method(D_METHOD("get_input_pids"), &AudioEffectTapCircuit::get_input_pids);
+  ClassDB::bind_method(D_METHOD("set_input_pids", "pids"), &AudioEffectTapCircuit::set_input_pids);
+  ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT64_ARRAY, "input_pids"), "set_input_pids", "get_input_pids");
+
+  ClassDB::bind_method(D_METHOD("get_output_pids"), &AudioEffectTapCircuit::get_output_pids);
+  ClassDB::bind_method(D_METHOD("set_output_pids", "pids"), &AudioEffectTapCircuit::set_output_pids);
+  ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT64_ARRAY, "output_pids"), "set_output_pids", "get_output_pids");
+
+  ClassDB::bind_method(D_METHOD("get_sample_skip"), &AudioEffectTapCircuit::get_sample_skip);
+  ClassDB::bind_method(D_METHOD("set_sample_skip", "sample_skip"), &AudioEffectTapCircuit::set_sample_skip);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "sample_skip", PROPERTY_HINT_RANGE, "1,64,1,or_greater"), "set_sample_skip", "get_sample_skip");
+
+  ClassDB::bind_method(D_METHOD("get_tick_rate"), &AudioEffectTapCircuit::get_tick_rate);
+  ClassDB::bind_method(D_METHOD("set_tick_rate", "tick_rate"), &AudioEffectTapCircuit::set_tick_rate);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "tick_rate", PROPERTY_HINT_RANGE, "1,1024,1,or_greater"), "set_tick_rate", "get_tick_rate");
+}
+
+Ref<TapCircuit> AudioEffectTapCircuit::get_circuit() const {
+  return circuit;
+}
+
+void AudioEffectTapCircuit::set_circuit(Ref<TapCircuit> new_circuit) {
+  circuit = new_circuit;
+}
+
+PackedInt64Array AudioEffectTapCircuit::get_input_pids() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  PackedInt64Array input_pids_copy(input_pids);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+  return input_pids_copy;
+}
+
+void AudioEffectTapCircuit::set_input_pids(const PackedInt64Array &new_input_pids) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  input_pids = new_input_pids;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+PackedInt64Array AudioEffectTapCircuit::get_output_pids() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  PackedInt64Array output_pids_copy(output_pids);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+  return output_pids_copy;
+}
+
+void AudioEffectTapCircuit::set_output_pids(const PackedInt64Array &new_output_pids) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  output_pids = new_output_pids;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioEffectTapCircuit::get_sample_skip() const {
+  return sample_skip;
+}
+
+void AudioEffectTapCircuit::set_sample_skip(int new_sample_skip) {
+  sample_skip = MAX(new_sample_skip, 1);
+}
+
+int AudioEffectTapCircuit::get_tick_rate() const {
+  return tick_rate;
+}
+
+void AudioEffectTapCircuit::set_tick_rate(int new_tick_rate) {
+  tick_rate = MAX(new_tick_rate, 1);
+}
+
+Ref<AudioEffectInstance> AudioEffectTapCircuit::instantiate() {
+  Ref<AudioEffectTapCircuitInstance> instance;
+  instance.instantiate();
+  instance->base = Ref<AudioEffectTapCircuit>(this);
+  instance->input_run.reserve(256);
+  return instance;
+}
+
+void AudioEffectTapCircuitInstance::_bind_methods() {}
+
+void AudioEffectTapCircuitInstance::process(const AudioFrame *p_src_frames, AudioFrame *p_dst_frames, int p_frame_count) {
+  Ref<TapCircuit> circuit = base->circuit;
+
+  bool locked = circuit.is_valid() && circuit->is_instantiated() && circuit->get_mutex().try_lock();
+  if (!locked) {
+    if (circuit.is_valid() && circuit->is_instantiated()) {
+      TapMonitors::record_dropped_block();
+    }
+    for (int i = 0; i < p_frame_count; i++) {
+      p_dst_frames[i] = p_src_frames[i];
+    }
+    return;
+  }
+
+  //a new instance or a swapped circuit starts the clock over, so drop
+  //anything queued or remembered from before and wake the sources
+  if (started_circuit != circuit->get_instance_id()) {
+    circuit->get_patch_bay()->clear_events_internal();
+    circuit->get_network()->reset_memory_internal();
+    current_time = 0;
+    skip_phase = 0;
+    circuit->start_sources(current_time);
+    started_circuit = circuit->get_instance_id();
+  }
+
+  Ref<TapPatchBay> patch_bay = circuit->get_patch_bay();
+  const int sample_skip = base->sample_skip;
+  const int tick_rate = base->tick_rate;
+
+  //check the pids once per buffer rather than once per frame
+  valid_inputs.clear();
+  for (int64_t pid : base->input_pids) {
+    if (patch_bay->has_pin(pid)) {
+      valid_inputs.push_back(pid);
+    }
+  }
+
+  valid_outputs.clear();
+  for (int64_t pid : base->output_pids) {
+    if (patch_bay->has_pin(pid)) {
+      valid_outputs.push_back(pid);
+    }
+  }
+
+  //the whole buffer is already here, so every input event for it can go in
+  //before simulating, as one sorted run per pid
+  int next_phase = skip_phase;
+  for (tap_label_t pid : valid_inputs) {
+    input_run.clear();
+    int j = skip_phase;
+    for (; j < p_frame_count; j += sample_skip) {
+      tap_time_t time = current_time + (tap_time_t)j * tick_rate;
+      input_run.push_back(tap_event_t{ time, p_src_frames[j], pid, TapPatchBay::COMPONENT_MISSING });
+    }
+    next_phase = j - p_frame_count;
+
+    circuit->push_event_run(pid, input_run);
+  }
+  skip_phase = next_phase;
+
+  for (int i = 0; i < p_frame_count; i++) {
+    circuit->process_to(current_time + (tap_time_t)i * tick_rate);
+
+    AudioFrame sum(0, 0);
+    for (tap_label_t pid : valid_outputs) {
+      sum += patch_bay->get_state_internal(pid)->state;
+    }
+    p_dst_frames[i] = sum;
+  }
+
+  current_time += (tap_time_t)p_frame_count * tick_rate;
+
+  circuit->get_mutex().unlock();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core/object/ref_counted.h"
+#include "servers/audio/audio_effect.h"
+
+#include "tap_circuit_types.h"
+#include "tap_circuit.h"
+
+class AudioEffectTapCircuitInstance;
+
+/**
+ * @brief Runs a TapCircuit in place on an audio bus.
+ *
+ * The bus signal is pushed straight into the circuit and the sum of the
+ * output pids replaces it, with no AudioStream playback or resampling in
+ * between. Latency is one bus buffer.
+ *
+ * @param circuit The TapCircuit to simulate.
+ * @param input_pids Pids that receive the bus signal. Bus frames are stereo
+ * like circuit pins, so each pid gets the whole frame.
+ * @param output_pids Pids that should be summed back into the bus.
+ *
+ * @param sample_skip Push every `sample_skip`-th bus frame as an event.
+ * @param tick_rate Circuit ticks per bus frame.
+ */
+class AudioEffectTapCircuit : public AudioEffect {
+  GDCLASS(AudioEffectTapCircuit, AudioEffect);
+  friend class AudioEffectTapCircuitInstance;
+
+  Ref<TapCircuit> circuit;
+
+  PackedInt64Array input_pids;
+  PackedInt64Array output_pids;
+
+  int sample_skip = 1;
+  int tick_rate = 1024;
+
+protected:
+  static void _bind_methods();
+
+public:
+  Ref<TapCircuit> get_circuit() const;
+  void set_circuit(Ref<TapCircuit> circuit);
+
+  PackedInt64Array get_input_pids() const;
+  void set_input_pids(const PackedInt64Array &pids);
+
+  PackedInt64Array get_output_pids() const;
+  void set_output_pids(const PackedInt64Array &pids);
+
+  int get_sample_skip() const;
+  void set_sample_skip(int sample_skip);
+
+  int get_tick_rate() const;
+  void set_tick_rate(int tick_rate);
+
+  virtual Ref<AudioEffectInstance> instantiate() override;
+};
+
+/**
+ * @brief Per-bus state for an AudioEffectTapCircuit.
+ *
+ * @param started_circuit The circuit whose sources were last started from
+ * here. Any other circuit is reset and started on the next buffer.
+ * @param current_time The circuit time at the start of the next buffer.
+ * @param skip_phase Frames left before the next input frame is due, carried
+ * across buffers.
+ * @param input_run Scratch run of input events handed to the circuit per pid.
+ * @param valid_inputs Input pids that exist in the circuit this buffer.
+ * @param valid_outputs Output pids that exist in the circuit this buffer.
+ */
+class AudioEffectTapCircuitInstance : public AudioEffectInstance {
+  GDCLASS(AudioEffectTapCircuitInstance, AudioEffectInstance);
+  friend class AudioEffectTapCircuit;
+
+  Ref<AudioEffectTapCircuit> base;
+
+  ObjectID started_circuit;
+  tap_time_t current_time = 0;
+  int skip_phase = 0;
+
+  LocalVector<tap_event_t> input_run;
+  LocalVector<tap_label_t> valid_inputs;
+  LocalVector<tap_label_t> valid_outputs;
+
+protected:
+  static void _bind_methods();
+
+public:
+  /**
+   * @brief Push the bus buffer into the input pids, simulate across it and
+   * write the output sum back out. Passes the bus through untouched if the
+   * circuit isn't ready or is busy.
+   *
+   * The first buffer on a circuit clears its events and memory and starts
+   * its sources, like starting an AudioStreamTapSimulator playback does.
+   */
+  virtual void process(const AudioFrame *p_src_frames, AudioFrame *p_dst_frames, int p_frame_count) override;
+};
@@ -28,82 +28,127 @@ void AudioStreamPrimitive::_bind_methods() {
   ClassDB::bind_method(D_METHOD("get_saw"), &AudioStreamPrimitive::get_saw);
   ClassDB::bind_method(D_METHOD("set_saw", "saw"), &AudioStreamPrimitive::set_saw);
   ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "saw"), "set_saw", "get_saw");
+
+  ClassDB::bind_method(D_METHOD("is_fast_oscillator"), &AudioStreamPrimitive::is_fast_oscillator);
+  ClassDB::bind_method(D_METHOD("set_fast_oscillator", "fast_oscillator"), &AudioStreamPrimitive::set_fast_oscillator);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "fast_oscillator"), "set_fast_oscillator", "is_fast_oscillator");
 }
 
 float AudioStreamPrimitive::get_frequency() const {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  return frequency;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return parameters.frequency;
 }
 
 void AudioStreamPrimitive::set_frequency(float p_frequency) {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  frequency = p_frequency;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.frequency = p_frequency;
+  publish_internal();
 }
 
 float AudioStreamPrimitive::get_amplitude() const {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  return CLAMP(amplitude, 0.0f, 1.0f);
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return CLAMP(parameters.amplitude, 0.0f, 1.0f);
 }
 
 void AudioStreamPrimitive::set_amplitude(float p_amplitude) {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  amplitude = p_amplitude;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.amplitude = p_amplitude;
+  publish_internal();
 }
 
 float AudioStreamPrimitive::get_sin() const {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  return sin;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return parameters.sin;
 }
 
 void AudioStreamPrimitive::set_sin(float p_sin) {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  sin = p_sin;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.sin = p_sin;
   normalize();
+  publish_internal();
 }
 
 float AudioStreamPrimitive::get_tri() const {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  return tri;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return parameters.tri;
 }
 
 void AudioStreamPrimitive::set_tri(float p_tri) {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  tri = p_tri;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.tri = p_tri;
   normalize();
+  publish_internal();
 }
 
 float AudioStreamPrimitive::get_sqr() const {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  return sqr;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return parameters.sqr;
 }
 
 void AudioStreamPrimitive::set_sqr(float p_sqr) {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  sqr = p_sqr;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.sqr = p_sqr;
   normalize();
+  publish_internal();
 }
 
 float AudioStreamPrimitive::get_saw() const {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  return saw;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return parameters.saw;
 }
 
 void AudioStreamPrimitive::set_saw(float p_saw) {
-  std::lock_guard<mutex_t> lock(audio_playback_mutex);
-  saw = p_saw;
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.saw = p_saw;
   normalize();
+  publish_internal();
+}
+
+bool AudioStreamPrimitive::is_fast_oscillator() const {
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  return parameters.fast_oscillator;
+}
+
+void AudioStreamPrimitive::set_fast_oscillator(bool p_fast_oscillator) {
+  std::lock_guard<mutex_t> lock(parameter_mutex);
+  parameters.fast_oscillator = p_fast_oscillator;
+  publish_internal();
 }
 
 void AudioStreamPrimitive::normalize() {
-  float total = sin + tri + sqr + saw;
+  float total = parameters.sin + parameters.tri + parameters.sqr + parameters.saw;
   if (total > 0.0f) {
-    sin /= total;
-    tri /= total;
-    sqr /= total;
-    saw /= total;
+    parameters.sin /= total;
+    parameters.tri /= total;
+    parameters.sqr /= total;
+    parameters.saw /= total;
   }
 }
 
+void AudioStreamPrimitive::publish_internal() {
+  uint32_t version = parameter_version.load(std::memory_order_relaxed);
+
+  //the playback may still be copying this slot from two versions ago. The fence
+  //keeps these writes after the last bump, so that copy sees the version move
+  std::atomic_thread_fence(std::memory_order_release);
+  published[(version + 1) & 1] = parameters;
+
+  parameter_version.store(version + 1, std::memory_order_release);
+}
+
+bool AudioStreamPrimitive::read_parameters_internal(parameters_t &r_parameters) const {
+  uint32_t version = parameter_version.load(std::memory_order_acquire);
+  parameters_t copy = published[version & 1];
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (parameter_version.load(std::memory_order_relaxed) != version) {
+    return false;
+  }
+
+  r_parameters = copy;
+  return true;
+}
+
 Ref<AudioStreamPlayback> AudioStreamPrimitive::instantiate_playback() {
 
   Ref<AudioStreamPrimitivePlayback> new_playback;
@@ -118,28 +163,51 @@ Ref<AudioStreamPlayback> AudioStreamPrimitive::instantiate_playback() {
 void AudioStreamPrimitivePlayback::_bind_methods() {
 }
 
+void AudioStreamPrimitivePlayback::set_mix_rate_internal(size_t p_mix_rate) {
+  ERR_FAIL_COND(p_mix_rate == 0);
+  mix_rate = p_mix_rate;
+}
+
 int AudioStreamPrimitivePlayback::mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
-  //use mutex to access stream data
-  if (!stream->audio_playback_mutex.try_lock()) {
+  //a setter racing this read costs one block of latency, not the block itself
+  stream->read_parameters_internal(parameters);
+
+  if (!playing || p_frames <= 0) {
     return 0;
   }
 
-  // Get stream settings
-  double freq = stream->frequency;
-  float amp = stream->amplitude;
-  float sin_weight = stream->sin;
-  float tri_weight = stream->tri;
-  float sqr_weight = stream->sqr;
-  float saw_weight = stream->saw;
+  //ramp frequency and amplitude from where the last block ended
+  if (!ramping) {
+    frequency = parameters.frequency;
+    amplitude = parameters.amplitude;
+    ramping = true;
+  }
 
-  stream->audio_playback_mutex.unlock();
+  double phase_increment = (frequency * p_rate_scale) / (double)mix_rate;
+  double end_increment = ((double)parameters.frequency * p_rate_scale) / (double)mix_rate;
 
-  if (!playing || p_frames <= 0) {
-    return 0;
+  if (parameters.fast_oscillator) {
+    oscillator.set_weights(parameters.sin, parameters.tri, parameters.sqr, parameters.saw);
+    oscillator.generate(p_buffer, p_frames, phase, phase_increment, end_increment, amplitude, parameters.amplitude);
+  } else {
+    mix_reference_internal(p_buffer, p_frames, phase_increment, end_increment, amplitude, parameters.amplitude);
   }
 
-  double phase_increment = (freq * p_rate_scale) / (double)mix_rate;
-  
+  frequency = parameters.frequency;
+  amplitude = parameters.amplitude;
+
+  return p_frames;
+}
+
+void AudioStreamPrimitivePlayback::mix_reference_internal(AudioFrame *p_buffer, int p_frames, double phase_increment, double end_increment, float gain, float end_gain) {
+  float sin_weight = parameters.sin;
+  float tri_weight = parameters.tri;
+  float sqr_weight = parameters.sqr;
+  float saw_weight = parameters.saw;
+
+  double increment_step = (end_increment - phase_increment) / (double)p_frames;
+  float gain_step = (end_gain - gain) / (float)p_frames;
+
   for (int i = 0; i < p_frames; i++) {
     double sample = 0.0;
     
@@ -168,17 +236,16 @@ int AudioStreamPrimitivePlayback::mix(AudioFrame *p_buffer, float p_rate_scale,
     }
     
     // Apply amplitude and write to buffer
-    sample *= amp;
+    sample *= gain + gain_step * (float)i;
     p_buffer[i] = AudioFrame(sample, sample);
     
     // Advance phase
     phase += phase_increment;
+    phase_increment += increment_step;
     if (phase >= 1.0) {
       phase -= Math::floor(phase);
     }
   }
-
-  return p_frames;
 }
 
 float AudioStreamPrimitivePlayback::get_stream_sampling_rate() {
@@ -191,6 +258,7 @@ double AudioStreamPrimitivePlayback::get_playback_position() const {
 
 void AudioStreamPrimitivePlayback::start(double start_time) {
   phase = start_time;
+  ramping = false;
   playing = true;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
 #include "core/typedefs.h"
@@ -8,22 +9,47 @@
 #include "scene/2d/audio_stream_player_2d.h"
 #include "servers/audio/audio_stream.h"
 
+#include "tap_dsp.h"
+
 class AudioStreamPrimitivePlayback;
 
 class AudioStreamPrimitive : public AudioStream {
   GDCLASS(AudioStreamPrimitive, AudioStream)
 	friend class AudioStreamPrimitivePlayback;
 
-  float frequency = 440.0f;
-  float amplitude = 1.0f;
+  //everything the playback reads, handed to it as one block
+  struct parameters_t {
+    float frequency = 440.0f;
+    float amplitude = 1.0f;
 
-  float sin = 1.0f;
-  float tri = 0.0f;
-  float sqr = 0.0f;
-  float saw = 0.0f;
+    float sin = 1.0f;
+    float tri = 0.0f;
+    float sqr = 0.0f;
+    float saw = 0.0f;
+
+    //band-limited float oscillator, or the naive double precision waveforms
+    bool fast_oscillator = true;
+  };
 
   using mutex_t = std::mutex;
-  mutable mutex_t audio_playback_mutex;
+
+  //the copy getters and setters work on. Only they take the lock
+  parameters_t parameters;
+  mutable mutex_t parameter_mutex;
+
+  /*
+  Double-buffered copy for the audio thread, written as a seqlock. A setter
+  fills the slot the version doesn't point at, then bumps the version. The
+  playback copies the current slot and keeps the copy only if the version
+  hasn't moved, so it never waits on a setter.
+  */
+  parameters_t published[2];
+  std::atomic<uint32_t> parameter_version{ 0 };
+
+  //call with parameter_mutex held
+  void publish_internal();
+  //audio thread. Leaves r_parameters alone and returns false if a setter raced the read
+  bool read_parameters_internal(parameters_t &r_parameters) const;
 
   protected:
     static void _bind_methods();
@@ -47,6 +73,9 @@ class AudioStreamPrimitive : public AudioStream {
     float get_saw() const;
     void set_saw(float p_saw);
 
+    bool is_fast_oscillator() const;
+    void set_fast_oscillator(bool p_fast_oscillator);
+
     void normalize();
 
     Ref<AudioStreamPlayback> instantiate_playback() override;
@@ -60,11 +89,23 @@ class AudioStreamPrimitivePlayback : public AudioStreamPlaybackResampled {
   AudioStreamPrimitive* stream = nullptr;
 	
   double phase = 0.0;
-  double frequency = 440.0;
   size_t mix_rate = 44100;
 
   bool playing = false;
 
+  //last parameters read from the stream, kept when a read loses a race
+  AudioStreamPrimitive::parameters_t parameters;
+  //where the frequency and amplitude ramps ended last block
+  double frequency = 440.0;
+  float amplitude = 1.0f;
+  //the first block after start jumps straight to the parameters
+  bool ramping = false;
+
+  tap_oscillator_t oscillator;
+
+  //the naive waveforms, kept as the reference the fast path is measured against
+  void mix_reference_internal(AudioFrame *p_buffer, int p_frames, double phase_increment, double end_increment, float gain, float end_gain);
+
 protected:
   static void _bind_methods();
 
@@ -87,6 +128,12 @@ public:
 
 	virtual void tag_used_streams() override;
 
+  /**
+   * @brief Generate at `p_mix_rate` rather than the AudioServer mix rate, for
+   * callers that pull frames themselves.
+   */
+  void set_mix_rate_internal(size_t p_mix_rate);
+
 	AudioStreamPrimitivePlayback();
 	~AudioStreamPrimitivePlayback();
 };
\ No newline at end of file
@@ -1,8 +1,13 @@
 #include "audio_stream_tap_simulator.h"
+#include "audio_stream_primitive.h"
 #include "core/object/object.h"
+#include "core/io/file_access.h"
+#include "core/os/os.h"
 #include "core/variant/variant.h"
 #include "servers/audio/audio_stream.h"
+#include "servers/audio_server.h"
 #include "tap_circuit_types.h"
+#include "tap_monitors.h"
 #include "tap_patch_bay.h"
 #include <iostream>
 #include <mutex>
@@ -36,11 +41,105 @@ void AudioStreamTapSimulator::_bind_methods() {
   ClassDB::bind_method(D_METHOD("set_tick_rate", "tick_rate"), &AudioStreamTapSimulator::set_tick_rate);
   ADD_PROPERTY(PropertyInfo(Variant::INT, "tick_rate"), "set_tick_rate", "get_tick_rate");
 
+  ClassDB::bind_method(D_METHOD("get_input_encoding"), &AudioStreamTapSimulator::get_input_encoding);
+  ClassDB::bind_method(D_METHOD("set_input_encoding", "encoding"), &AudioStreamTapSimulator::set_input_encoding);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "input_encoding", PROPERTY_HINT_ENUM, "Sampled,Change"), "set_input_encoding", "get_input_encoding");
+
+  ClassDB::bind_method(D_METHOD("get_input_threshold"), &AudioStreamTapSimulator::get_input_threshold);
+  ClassDB::bind_method(D_METHOD("set_input_threshold", "threshold"), &AudioStreamTapSimulator::set_input_threshold);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "input_threshold", PROPERTY_HINT_RANGE, "0,131070"), "set_input_threshold", "get_input_threshold");
+
+  ClassDB::bind_method(D_METHOD("get_input_thresholds"), &AudioStreamTapSimulator::get_input_thresholds);
+  ClassDB::bind_method(D_METHOD("set_input_thresholds", "thresholds"), &AudioStreamTapSimulator::set_input_thresholds);
+  ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "input_thresholds", PROPERTY_HINT_DICTIONARY_TYPE, "int:int"), "set_input_thresholds", "get_input_thresholds");
+
+  ClassDB::bind_method(D_METHOD("get_input_hysteresis"), &AudioStreamTapSimulator::get_input_hysteresis);
+  ClassDB::bind_method(D_METHOD("set_input_hysteresis", "hysteresis"), &AudioStreamTapSimulator::set_input_hysteresis);
+  ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "input_hysteresis", PROPERTY_HINT_DICTIONARY_TYPE, "int:float"), "set_input_hysteresis", "get_input_hysteresis");
+
+  ClassDB::bind_method(D_METHOD("get_input_decimation"), &AudioStreamTapSimulator::get_input_decimation);
+  ClassDB::bind_method(D_METHOD("set_input_decimation", "decimation"), &AudioStreamTapSimulator::set_input_decimation);
+  ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "input_decimation", PROPERTY_HINT_DICTIONARY_TYPE, "int:int"), "set_input_decimation", "get_input_decimation");
+
+  ClassDB::bind_method(D_METHOD("get_antialias_inputs"), &AudioStreamTapSimulator::get_antialias_inputs);
+  ClassDB::bind_method(D_METHOD("set_antialias_inputs", "antialias"), &AudioStreamTapSimulator::set_antialias_inputs);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "antialias_inputs"), "set_antialias_inputs", "get_antialias_inputs");
+
+  ClassDB::bind_method(D_METHOD("get_event_budget"), &AudioStreamTapSimulator::get_event_budget);
+  ClassDB::bind_method(D_METHOD("set_event_budget", "budget"), &AudioStreamTapSimulator::set_event_budget);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "event_budget", PROPERTY_HINT_RANGE, "0,1000000,1,or_greater"), "set_event_budget", "get_event_budget");
+
+  ClassDB::bind_method(D_METHOD("get_time_budget_usec"), &AudioStreamTapSimulator::get_time_budget_usec);
+  ClassDB::bind_method(D_METHOD("set_time_budget_usec", "budget_usec"), &AudioStreamTapSimulator::set_time_budget_usec);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "time_budget_usec", PROPERTY_HINT_RANGE, "0,100000,1,or_greater,suffix:us"), "set_time_budget_usec", "get_time_budget_usec");
+
+  ClassDB::bind_method(D_METHOD("get_deadline_miss_count"), &AudioStreamTapSimulator::get_deadline_miss_count);
+  ClassDB::bind_method(D_METHOD("get_backlog_depth"), &AudioStreamTapSimulator::get_backlog_depth);
+  ClassDB::bind_method(D_METHOD("get_simulation_lag"), &AudioStreamTapSimulator::get_simulation_lag);
+  ClassDB::bind_method(D_METHOD("reset_deadline_stats"), &AudioStreamTapSimulator::reset_deadline_stats);
+  ClassDB::bind_method(D_METHOD("get_calculate_stats"), &AudioStreamTapSimulator::get_calculate_stats);
+  ClassDB::bind_method(D_METHOD("set_calculate_stats", "enabled"), &AudioStreamTapSimulator::set_calculate_stats);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "calculate_stats"), "set_calculate_stats", "get_calculate_stats");
+
+  ClassDB::bind_method(D_METHOD("get_stats_interval"), &AudioStreamTapSimulator::get_stats_interval);
+  ClassDB::bind_method(D_METHOD("set_stats_interval", "seconds"), &AudioStreamTapSimulator::set_stats_interval);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "stats_interval", PROPERTY_HINT_RANGE, "0.01,10,0.01,or_greater,suffix:s"), "set_stats_interval", "get_stats_interval");
+
+  ClassDB::bind_method(D_METHOD("get_output_stats"), &AudioStreamTapSimulator::get_output_stats);
+  ADD_SIGNAL(MethodInfo("output_stats_updated", PropertyInfo(Variant::DICTIONARY, "stats")));
+
+  ClassDB::bind_method(D_METHOD("get_latency_histograms"), &AudioStreamTapSimulator::get_latency_histograms);
+  ClassDB::bind_method(D_METHOD("reset_latency_histograms"), &AudioStreamTapSimulator::reset_latency_histograms);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "deadline_miss_count", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "", "get_deadline_miss_count");
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "backlog_depth", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "", "get_backlog_depth");
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "simulation_lag", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "", "get_simulation_lag");
+
+  ClassDB::bind_method(D_METHOD("get_adaptive_quality"), &AudioStreamTapSimulator::get_adaptive_quality);
+  ClassDB::bind_method(D_METHOD("set_adaptive_quality", "enabled"), &AudioStreamTapSimulator::set_adaptive_quality);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "adaptive_quality"), "set_adaptive_quality", "get_adaptive_quality");
+
+  ClassDB::bind_method(D_METHOD("get_adaptive_scale_tick_rate"), &AudioStreamTapSimulator::get_adaptive_scale_tick_rate);
+  ClassDB::bind_method(D_METHOD("set_adaptive_scale_tick_rate", "enabled"), &AudioStreamTapSimulator::set_adaptive_scale_tick_rate);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "adaptive_scale_tick_rate"), "set_adaptive_scale_tick_rate", "get_adaptive_scale_tick_rate");
+
+  ClassDB::bind_method(D_METHOD("get_adaptive_high_load"), &AudioStreamTapSimulator::get_adaptive_high_load);
+  ClassDB::bind_method(D_METHOD("set_adaptive_high_load", "load"), &AudioStreamTapSimulator::set_adaptive_high_load);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "adaptive_high_load", PROPERTY_HINT_RANGE, "0.05,2.0,0.01"), "set_adaptive_high_load", "get_adaptive_high_load");
+
+  ClassDB::bind_method(D_METHOD("get_adaptive_low_load"), &AudioStreamTapSimulator::get_adaptive_low_load);
+  ClassDB::bind_method(D_METHOD("set_adaptive_low_load", "load"), &AudioStreamTapSimulator::set_adaptive_low_load);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "adaptive_low_load", PROPERTY_HINT_RANGE, "0.0,2.0,0.01"), "set_adaptive_low_load", "get_adaptive_low_load");
+
+  ClassDB::bind_method(D_METHOD("get_max_quality_level"), &AudioStreamTapSimulator::get_max_quality_level);
+  ClassDB::bind_method(D_METHOD("set_max_quality_level", "level"), &AudioStreamTapSimulator::set_max_quality_level);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "max_quality_level", PROPERTY_HINT_RANGE, "0,8"), "set_max_quality_level", "get_max_quality_level");
+
+  ClassDB::bind_method(D_METHOD("get_quality_level"), &AudioStreamTapSimulator::get_quality_level);
+  ClassDB::bind_method(D_METHOD("get_load"), &AudioStreamTapSimulator::get_load);
+  ClassDB::bind_method(D_METHOD("get_quality_raise_count"), &AudioStreamTapSimulator::get_quality_raise_count);
+  ClassDB::bind_method(D_METHOD("get_quality_restore_count"), &AudioStreamTapSimulator::get_quality_restore_count);
+  ClassDB::bind_method(D_METHOD("get_effective_sample_skip"), &AudioStreamTapSimulator::get_effective_sample_skip);
+  ClassDB::bind_method(D_METHOD("get_effective_tick_rate"), &AudioStreamTapSimulator::get_effective_tick_rate);
+
+  ClassDB::bind_method(D_METHOD("get_shared_simulation"), &AudioStreamTapSimulator::get_shared_simulation);
+  ClassDB::bind_method(D_METHOD("set_shared_simulation", "shared"), &AudioStreamTapSimulator::set_shared_simulation);
+  ADD_PROPERTY(PropertyInfo(Variant::BOOL, "shared_simulation"), "set_shared_simulation", "get_shared_simulation");
+
+  ClassDB::bind_method(D_METHOD("render_offline", "seconds", "path"), &AudioStreamTapSimulator::render_offline, DEFVAL(String()));
+  ClassDB::bind_method(D_METHOD("get_last_render_stats"), &AudioStreamTapSimulator::get_last_render_stats);
+
+  ADD_SIGNAL(MethodInfo("quality_changed", PropertyInfo(Variant::INT, "level"), PropertyInfo(Variant::INT, "sample_skip"), PropertyInfo(Variant::INT, "tick_rate")));
+
+  BIND_ENUM_CONSTANT(INPUT_ENCODING_SAMPLED);
+  BIND_ENUM_CONSTANT(INPUT_ENCODING_CHANGE);
+
   ClassDB::bind_method(D_METHOD("get_live"), &AudioStreamTapSimulator::is_simulating);
   ADD_PROPERTY(PropertyInfo(Variant::BOOL, "live", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR), "", "get_live");
 
   ClassDB::bind_method(D_METHOD("get_event_counts"), &AudioStreamTapSimulator::get_event_counts);
   ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT64_ARRAY, "event_counts"), "", "get_event_counts");
+
+  ClassDB::bind_method(D_METHOD("get_event_reduction_ratios"), &AudioStreamTapSimulator::get_event_reduction_ratios);
 }
 
 TypedDictionary<tap_label_t, Ref<AudioStream>> AudioStreamTapSimulator::get_input_streams() const {
@@ -143,80 +242,764 @@ void AudioStreamTapSimulator::set_circuit(Ref<TapCircuit> new_circuit) {
   }
 }
 
-Ref<ReferenceSim> AudioStreamTapSimulator::get_reference_sim() const {
+Ref<ReferenceSim> AudioStreamTapSimulator::get_reference_sim() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+  
+  Ref<ReferenceSim> reference_sim_copy = reference_sim;
+  
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+  return reference_sim_copy;
+}
+
+void AudioStreamTapSimulator::set_reference_sim(Ref<ReferenceSim> new_reference_sim) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+  
+  reference_sim = new_reference_sim;
+  
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_tick_rate() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+  
+  int tick_rate_copy = tick_rate;
+  
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+  return tick_rate_copy;
+}
+
+void AudioStreamTapSimulator::set_tick_rate(int new_tick_rate) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+  
+  tick_rate = new_tick_rate;
+  update_effective_rates_internal();
+  
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_sample_skip() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int sample_skip_copy = sample_skip;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return sample_skip_copy;
+}
+
+void AudioStreamTapSimulator::set_sample_skip(int new_sample_skip) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+  
+  sample_skip = new_sample_skip;
+  update_effective_rates_internal();
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+AudioStreamTapSimulator::InputEncoding AudioStreamTapSimulator::get_input_encoding() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  InputEncoding input_encoding_copy = input_encoding;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return input_encoding_copy;
+}
+
+void AudioStreamTapSimulator::set_input_encoding(InputEncoding new_input_encoding) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  input_encoding = new_input_encoding;
+
+  //start every encoder fresh so the first frame after the switch gets through
+  for (auto &kv : trackers) {
+    kv.value.has_sent = false;
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_input_threshold() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int input_threshold_copy = input_threshold;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return input_threshold_copy;
+}
+
+void AudioStreamTapSimulator::set_input_threshold(int new_input_threshold) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  input_threshold = MAX(new_input_threshold, 0);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+TypedDictionary<tap_label_t, int> AudioStreamTapSimulator::get_input_thresholds() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  TypedDictionary<tap_label_t, int> dict;
+  for (const auto &kv : input_thresholds) {
+    dict.set(kv.key, kv.value);
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return dict;
+}
+
+void AudioStreamTapSimulator::set_input_thresholds(const TypedDictionary<tap_label_t, int> &p_thresholds) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  input_thresholds.clear();
+  for (auto kv : p_thresholds) {
+    input_thresholds.insert(kv.key, MAX((int)kv.value, 0));
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+TypedDictionary<tap_label_t, float> AudioStreamTapSimulator::get_input_hysteresis() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  TypedDictionary<tap_label_t, float> dict;
+  for (const auto &kv : input_hysteresis) {
+    dict.set(kv.key, kv.value);
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return dict;
+}
+
+void AudioStreamTapSimulator::set_input_hysteresis(const TypedDictionary<tap_label_t, float> &p_hysteresis) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  input_hysteresis.clear();
+  for (auto kv : p_hysteresis) {
+    input_hysteresis.insert(kv.key, CLAMP((float)kv.value, 0.0f, 1.0f));
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+TypedDictionary<tap_label_t, int> AudioStreamTapSimulator::get_input_decimation() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  TypedDictionary<tap_label_t, int> dict;
+  for (const auto &kv : input_decimation) {
+    dict.set(kv.key, kv.value);
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return dict;
+}
+
+void AudioStreamTapSimulator::set_input_decimation(const TypedDictionary<tap_label_t, int> &p_decimation) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  input_decimation.clear();
+  for (auto kv : p_decimation) {
+    input_decimation.insert(kv.key, MAX((int)kv.value, 1));
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+bool AudioStreamTapSimulator::get_antialias_inputs() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  bool antialias_inputs_copy = antialias_inputs;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return antialias_inputs_copy;
+}
+
+void AudioStreamTapSimulator::set_antialias_inputs(bool new_antialias_inputs) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  antialias_inputs = new_antialias_inputs;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_event_budget() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int event_budget_copy = event_budget;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return event_budget_copy;
+}
+
+void AudioStreamTapSimulator::set_event_budget(int new_event_budget) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  event_budget = MAX(new_event_budget, 0);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_time_budget_usec() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int time_budget_usec_copy = time_budget_usec;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return time_budget_usec_copy;
+}
+
+void AudioStreamTapSimulator::set_time_budget_usec(int new_time_budget_usec) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  time_budget_usec = MAX(new_time_budget_usec, 0);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int64_t AudioStreamTapSimulator::get_deadline_miss_count() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int64_t deadline_miss_count_copy = deadline_miss_count;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return deadline_miss_count_copy;
+}
+
+int64_t AudioStreamTapSimulator::get_backlog_depth() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int64_t backlog_depth_copy = backlog_depth;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return backlog_depth_copy;
+}
+
+int64_t AudioStreamTapSimulator::get_simulation_lag() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int64_t simulation_lag_copy = simulation_lag;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return simulation_lag_copy;
+}
+
+void AudioStreamTapSimulator::reset_deadline_stats() {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  deadline_miss_count = 0;
+  backlog_depth = 0;
+  simulation_lag = 0;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+bool AudioStreamTapSimulator::get_calculate_stats() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  bool calculate_stats_copy = calculate_stats;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return calculate_stats_copy;
+}
+
+void AudioStreamTapSimulator::set_calculate_stats(bool enabled) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  if (enabled && !calculate_stats) {
+    //start the first window fresh
+    stats_frames_pending = 0;
+    last_stats_snapshot = output_stats.snapshot();
+    output_stats.take_peak();
+  }
+  calculate_stats = enabled;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+double AudioStreamTapSimulator::get_stats_interval() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  double stats_interval_copy = stats_interval;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return stats_interval_copy;
+}
+
+void AudioStreamTapSimulator::set_stats_interval(double seconds) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  stats_interval = MAX(seconds, 0.01);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+Dictionary AudioStreamTapSimulator::get_output_stats() const {
+  return last_output_stats.duplicate();
+}
+
+void AudioStreamTapSimulator::publish_output_stats() {
+  tap_stats_accumulator_t::snapshot_t snap = output_stats.snapshot();
+  AudioFrame peak = output_stats.take_peak();
+
+  uint64_t frames = snap.frames - last_stats_snapshot.frames;
+  if (frames == 0) {
+    return;
+  }
+
+  double dc[2];
+  double rms[2];
+  for (int c = 0; c < 2; c++) {
+    dc[c] = (snap.sum[c] - last_stats_snapshot.sum[c]) / frames;
+    rms[c] = Math::sqrt(MAX(snap.squares[c] - last_stats_snapshot.squares[c], 0.0) / frames);
+  }
+  last_stats_snapshot = snap;
+
+  Dictionary stats;
+  stats["frames"] = (int64_t)frames;
+  stats["dc_offset"] = Vector2(dc[0], dc[1]);
+  stats["rms"] = Vector2(rms[0], rms[1]);
+  stats["peak"] = Vector2(peak.left, peak.right);
+  last_output_stats = stats;
+
+  print_verbose(vformat("AudioStreamTapSimulator: output dc %s, rms %s, peak %s", stats["dc_offset"], stats["rms"], stats["peak"]));
+  emit_signal(SNAME("output_stats_updated"), stats);
+}
+
+Dictionary AudioStreamTapSimulator::get_latency_histograms() const {
+  static const char *stage_names[MIX_STAGE_COUNT] = { "mix_debug", "mix_in", "mix_out", "mix_stats", "total" };
+
+  Dictionary dict;
+  for (int i = 0; i < MIX_STAGE_COUNT; i++) {
+    dict[stage_names[i]] = stage_latency[i].to_dictionary(1000.0);
+  }
+  dict["utilization"] = block_utilization.to_dictionary(1000000.0);
+  return dict;
+}
+
+void AudioStreamTapSimulator::reset_latency_histograms() {
+  for (int i = 0; i < MIX_STAGE_COUNT; i++) {
+    stage_latency[i].reset();
+  }
+  block_utilization.reset();
+}
+
+bool AudioStreamTapSimulator::get_adaptive_quality() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  bool adaptive_quality_copy = adaptive_quality;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return adaptive_quality_copy;
+}
+
+void AudioStreamTapSimulator::set_adaptive_quality(bool new_adaptive_quality) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  adaptive_quality = new_adaptive_quality;
+
+  update_effective_rates_internal();
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+bool AudioStreamTapSimulator::get_adaptive_scale_tick_rate() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  bool adaptive_scale_tick_rate_copy = adaptive_scale_tick_rate;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return adaptive_scale_tick_rate_copy;
+}
+
+void AudioStreamTapSimulator::set_adaptive_scale_tick_rate(bool new_adaptive_scale_tick_rate) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  adaptive_scale_tick_rate = new_adaptive_scale_tick_rate;
+
+  update_effective_rates_internal();
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+float AudioStreamTapSimulator::get_adaptive_high_load() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  float adaptive_high_load_copy = adaptive_high_load;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return adaptive_high_load_copy;
+}
+
+void AudioStreamTapSimulator::set_adaptive_high_load(float new_adaptive_high_load) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  adaptive_high_load = MAX(new_adaptive_high_load, 0.05f);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+float AudioStreamTapSimulator::get_adaptive_low_load() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  float adaptive_low_load_copy = adaptive_low_load;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return adaptive_low_load_copy;
+}
+
+void AudioStreamTapSimulator::set_adaptive_low_load(float new_adaptive_low_load) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  adaptive_low_load = MAX(new_adaptive_low_load, 0.0f);
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_max_quality_level() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  int max_quality_level_copy = max_quality_level;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return max_quality_level_copy;
+}
+
+void AudioStreamTapSimulator::set_max_quality_level(int new_max_quality_level) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  max_quality_level = CLAMP(new_max_quality_level, 0, MAX_QUALITY_LEVEL);
+
+  update_effective_rates_internal();
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+int AudioStreamTapSimulator::get_quality_level() const {
   if (circuit.is_valid()) {
     circuit->get_mutex().lock();
   }
-  
-  Ref<ReferenceSim> reference_sim_copy = reference_sim;
-  
+
+  int quality_level_copy = quality_level;
+
   if (circuit.is_valid()) {
     circuit->get_mutex().unlock();
   }
-  return reference_sim_copy;
+
+  return quality_level_copy;
 }
 
-void AudioStreamTapSimulator::set_reference_sim(Ref<ReferenceSim> new_reference_sim) {
+double AudioStreamTapSimulator::get_load() const {
   if (circuit.is_valid()) {
     circuit->get_mutex().lock();
   }
-  
-  reference_sim = new_reference_sim;
-  
+
+  double load_copy = load;
+
   if (circuit.is_valid()) {
     circuit->get_mutex().unlock();
   }
+
+  return load_copy;
 }
 
-int AudioStreamTapSimulator::get_tick_rate() const {
+int64_t AudioStreamTapSimulator::get_quality_raise_count() const {
   if (circuit.is_valid()) {
     circuit->get_mutex().lock();
   }
-  
-  int tick_rate_copy = tick_rate;
-  
+
+  int64_t quality_raise_count_copy = quality_raise_count;
+
   if (circuit.is_valid()) {
     circuit->get_mutex().unlock();
   }
-  return tick_rate_copy;
+
+  return quality_raise_count_copy;
 }
 
-void AudioStreamTapSimulator::set_tick_rate(int new_tick_rate) {
+int64_t AudioStreamTapSimulator::get_quality_restore_count() const {
   if (circuit.is_valid()) {
     circuit->get_mutex().lock();
   }
-  
-  tick_rate = new_tick_rate;
-  
+
+  int64_t quality_restore_count_copy = quality_restore_count;
+
   if (circuit.is_valid()) {
     circuit->get_mutex().unlock();
   }
+
+  return quality_restore_count_copy;
 }
 
-int AudioStreamTapSimulator::get_sample_skip() const {
+int AudioStreamTapSimulator::get_effective_sample_skip() const {
   if (circuit.is_valid()) {
     circuit->get_mutex().lock();
   }
 
-  int sample_skip_copy = sample_skip;
+  int effective_sample_skip_copy = effective_sample_skip;
 
   if (circuit.is_valid()) {
     circuit->get_mutex().unlock();
   }
 
-  return sample_skip_copy;
+  return effective_sample_skip_copy;
 }
 
-void AudioStreamTapSimulator::set_sample_skip(int new_sample_skip) {
+int AudioStreamTapSimulator::get_effective_tick_rate() const {
   if (circuit.is_valid()) {
     circuit->get_mutex().lock();
   }
-  
-  sample_skip = new_sample_skip;
+
+  int effective_tick_rate_copy = effective_tick_rate;
 
   if (circuit.is_valid()) {
     circuit->get_mutex().unlock();
   }
+
+  return effective_tick_rate_copy;
+}
+
+void AudioStreamTapSimulator::update_effective_rates_internal() {
+  //keep the level inside what the settings allow before deriving the rates
+  if (!adaptive_quality) {
+    quality_level = 0;
+  } else if (quality_level > max_quality_level) {
+    quality_level = max_quality_level;
+  }
+
+  effective_sample_skip = MAX(sample_skip, 1) << quality_level;
+  effective_tick_rate = adaptive_scale_tick_rate ? MAX(tick_rate >> quality_level, 1) : tick_rate;
+}
+
+void AudioStreamTapSimulator::update_quality_internal(uint64_t elapsed_usec, double block_usec) {
+  if (!adaptive_quality || block_usec <= 0.0) {
+    return;
+  }
+
+  //smooth over a few blocks so a single slow callback doesn't trip it
+  static constexpr double LOAD_SMOOTHING = 0.1;
+  //blocks the load has to stay out of band before the level moves. Restoring
+  //waits longer than degrading so the level doesn't flap at the boundary.
+  static constexpr int RAISE_HOLD_BLOCKS = 8;
+  static constexpr int RESTORE_HOLD_BLOCKS = 64;
+
+  double block_load = (double)elapsed_usec / block_usec;
+  load += (block_load - load) * LOAD_SMOOTHING;
+
+  int new_level = quality_level;
+  if (load > adaptive_high_load) {
+    blocks_out_of_band = blocks_out_of_band > 0 ? blocks_out_of_band + 1 : 1;
+    if (blocks_out_of_band >= RAISE_HOLD_BLOCKS && quality_level < max_quality_level) {
+      new_level = quality_level + 1;
+    }
+  } else if (load < adaptive_low_load) {
+    blocks_out_of_band = blocks_out_of_band < 0 ? blocks_out_of_band - 1 : -1;
+    if (-blocks_out_of_band >= RESTORE_HOLD_BLOCKS && quality_level > 0) {
+      new_level = quality_level - 1;
+    }
+  } else {
+    blocks_out_of_band = 0;
+  }
+
+  if (new_level == quality_level) {
+    return;
+  }
+
+  if (new_level > quality_level) {
+    quality_raise_count++;
+  } else {
+    quality_restore_count++;
+  }
+
+  quality_level = new_level;
+  blocks_out_of_band = 0;
+  //the new rates take a few blocks to show up in the load, so start the
+  //average fresh between the two thresholds
+  load = (adaptive_high_load + adaptive_low_load) * 0.5;
+  update_effective_rates_internal();
+
+  //running on the audio thread, so leave the signal to the main thread
+  callable_mp(this, &AudioStreamTapSimulator::emit_quality_changed).call_deferred(quality_level, effective_sample_skip, effective_tick_rate);
+}
+
+void AudioStreamTapSimulator::emit_quality_changed(int level, int new_sample_skip, int new_tick_rate) {
+  emit_signal(SNAME("quality_changed"), level, new_sample_skip, new_tick_rate);
 }
 
 bool AudioStreamTapSimulator::is_simulating() const {
@@ -224,7 +1007,7 @@ bool AudioStreamTapSimulator::is_simulating() const {
     circuit->get_mutex().lock();
   }
 
-  bool live = false;
+  bool live = sources_running;
   for (auto kv : trackers) {
     if (kv.value.playback->is_playing()) {
       live = true;
@@ -269,28 +1052,38 @@ bool AudioStreamTapSimulator::can_simulate() const {
   return true;
 }
 
-Ref<AudioStreamPlayback> AudioStreamTapSimulator::instantiate_playback() {
+Ref<AudioStreamTapSimulatorPlayback> AudioStreamTapSimulator::instantiate_simulation_internal(bool offline) {
+
+  // Create a new instance of AudioStreamTapSimulatorPlayback
+  Ref<AudioStreamTapSimulatorPlayback> playback;
+  playback.instantiate();
+
+  //an offline render keeps its own trackers and runs at full quality
+  HashMap<tap_label_t,playback_tracker_t> &target = offline ? playback->offline_trackers : trackers;
+  playback->offline = offline;
+  playback->offline_sample_skip = MAX(sample_skip, 1);
+  playback->offline_tick_rate = tick_rate;
 
-  trackers.clear();
+  target.clear();
 
   for (auto kv : input_streams) {
     Ref<AudioStream> stream = kv.stream;
     if (!stream.is_valid()) {
       ERR_PRINT("Stream is not valid");
-      return Ref<AudioStreamPlayback>();
+      return Ref<AudioStreamTapSimulatorPlayback>();
     }
 
-    trackers[kv.pid] = {stream->instantiate_playback(), 0};
+    playback_tracker_t tracker;
+    tracker.playback = stream->instantiate_playback();
+    target[kv.pid] = tracker;
   }
 
-  // Create a new instance of AudioStreamTapSimulatorPlayback
-  Ref<AudioStreamTapSimulatorPlayback> playback;
-  playback.instantiate();
-
   for (auto kv : input_streams) {
     playback->debug_input_pids.insert(kv.pid);
   }
 
+  playback->input_run.reserve(AudioStreamTapSimulatorPlayback::MIX_BUFFER_SIZE);
+  playback->mix_rate = AudioServer::get_singleton()->get_mix_rate();
   playback->problem.resize(input_streams.size());
   playback->solution.resize(output_pids.size());  
   
@@ -300,6 +1093,179 @@ Ref<AudioStreamPlayback> AudioStreamTapSimulator::instantiate_playback() {
   return playback;
 }
 
+Ref<AudioStreamPlayback> AudioStreamTapSimulator::instantiate_playback() {
+  if (!shared_simulation) {
+    return instantiate_simulation_internal();
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  //the first reader sets up the one simulation every reader shares
+  if (shared_driver.is_null()) {
+    shared_driver = instantiate_simulation_internal();
+    broadcast_buffer.resize(BROADCAST_BUFFER_SIZE);
+    broadcast_written = 0;
+    shared_readers_playing = 0;
+  }
+
+  Ref<AudioStreamTapSimulatorPlayback> reader;
+  if (shared_driver.is_valid()) {
+    reader.instantiate();
+    reader->owner = this;
+    reader->shared_reader = true;
+    reader->mix_rate = shared_driver->mix_rate;
+  }
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return reader;
+}
+
+bool AudioStreamTapSimulator::get_shared_simulation() const {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  bool shared_simulation_copy = shared_simulation;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+
+  return shared_simulation_copy;
+}
+
+void AudioStreamTapSimulator::set_shared_simulation(bool new_shared_simulation) {
+  if (circuit.is_valid()) {
+    circuit->get_mutex().lock();
+  }
+
+  shared_simulation = new_shared_simulation;
+
+  //drop the old driver. Readers made before the switch go quiet, and the next
+  //instantiate_playback builds a fresh one.
+  if (shared_driver.is_valid()) {
+    shared_driver->stop();
+    shared_driver.unref();
+  }
+  broadcast_buffer.clear();
+  broadcast_written = 0;
+  shared_readers_playing = 0;
+  shared_generation++;
+
+  if (circuit.is_valid()) {
+    circuit->get_mutex().unlock();
+  }
+}
+
+PackedVector2Array AudioStreamTapSimulator::render_offline(double seconds, const String &path) {
+  ERR_FAIL_COND_V_MSG(!can_simulate(), PackedVector2Array(), "AudioStreamTapSimulator::render_offline: circuit, inputs or outputs are not set up.");
+  ERR_FAIL_COND_V_MSG(is_simulating(), PackedVector2Array(), "AudioStreamTapSimulator::render_offline: stop live playback before rendering offline.");
+  ERR_FAIL_COND_V_MSG(seconds <= 0.0, PackedVector2Array(), "AudioStreamTapSimulator::render_offline: seconds must be positive.");
+
+  static constexpr int RENDER_BLOCK_SIZE = 512;
+
+  int mix_rate = (int)AudioServer::get_singleton()->get_mix_rate();
+  int64_t total_frames = (int64_t)(seconds * mix_rate);
+
+  Ref<AudioStreamTapSimulatorPlayback> playback;
+  {
+    std::lock_guard<std::recursive_mutex> lock(circuit->get_mutex());
+    playback = instantiate_simulation_internal(true);
+  }
+  ERR_FAIL_COND_V(playback.is_null(), PackedVector2Array());
+
+  playback->start(0.0);
+
+  PackedVector2Array frames;
+  frames.resize(total_frames);
+  Vector2 *frames_w = frames.ptrw();
+
+  AudioFrame block[RENDER_BLOCK_SIZE];
+  int64_t done = 0;
+  uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+
+  while (done < total_frames) {
+    int to_mix = (int)MIN((int64_t)RENDER_BLOCK_SIZE, total_frames - done);
+    playback->mix_simulation(block, 1.0f, to_mix);
+
+    for (int i = 0; i < to_mix; i++) {
+      frames_w[done + i] = Vector2(block[i].left, block[i].right);
+    }
+    done += to_mix;
+
+    //finite inputs ran out
+    if (!playback->offline_trackers.is_empty() && !playback->is_playing()) {
+      break;
+    }
+  }
+
+  uint64_t wall_usec = OS::get_singleton()->get_ticks_usec() - start_usec;
+
+  playback->stop();
+  frames.resize(done);
+
+  double rendered_seconds = (double)done / (double)mix_rate;
+  last_render_stats.clear();
+  last_render_stats["frames"] = done;
+  last_render_stats["seconds"] = rendered_seconds;
+  last_render_stats["events"] = (int64_t)playback->processed_events_count;
+  last_render_stats["wall_usec"] = (int64_t)wall_usec;
+  last_render_stats["realtime_factor"] = wall_usec > 0 ? rendered_seconds * 1000000.0 / (double)wall_usec : 0.0;
+
+  if (!path.is_empty()) {
+    Error err = write_wav_internal(path, frames, mix_rate);
+    if (err != OK) {
+      ERR_PRINT("AudioStreamTapSimulator::render_offline: could not write " + path);
+    }
+  }
+
+  return frames;
+}
+
+Dictionary AudioStreamTapSimulator::get_last_render_stats() const {
+  return last_render_stats.duplicate();
+}
+
+Error AudioStreamTapSimulator::write_wav_internal(const String &path, const PackedVector2Array &frames, int mix_rate) {
+  Error err;
+  Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE, &err);
+  if (file.is_null()) {
+    return err;
+  }
+
+  const uint32_t channels = 2;
+  const uint32_t bytes_per_sample = 2;
+  const uint32_t data_size = frames.size() * channels * bytes_per_sample;
+
+  file->store_buffer((const uint8_t *)"RIFF", 4);
+  file->store_32(36 + data_size);
+  file->store_buffer((const uint8_t *)"WAVE", 4);
+
+  file->store_buffer((const uint8_t *)"fmt ", 4);
+  file->store_32(16);
+  file->store_16(1); //PCM
+  file->store_16(channels);
+  file->store_32(mix_rate);
+  file->store_32(mix_rate * channels * bytes_per_sample);
+  file->store_16(channels * bytes_per_sample);
+  file->store_16(bytes_per_sample * 8);
+
+  file->store_buffer((const uint8_t *)"data", 4);
+  file->store_32(data_size);
+
+  for (const Vector2 &frame : frames) {
+    file->store_16((uint16_t)(int16_t)(CLAMP(frame.x, -1.0f, 1.0f) * 32767.0f));
+    file->store_16((uint16_t)(int16_t)(CLAMP(frame.y, -1.0f, 1.0f) * 32767.0f));
+  }
+
+  return OK;
+}
+
 PackedInt64Array AudioStreamTapSimulator::get_event_counts() const {
   if (!circuit.is_valid()) {
     return PackedInt64Array();
@@ -314,6 +1280,65 @@ PackedInt64Array AudioStreamTapSimulator::get_event_counts() const {
   return arr;
 }
 
+PackedFloat64Array AudioStreamTapSimulator::get_event_reduction_ratios() const {
+  if (!circuit.is_valid()) {
+    return PackedFloat64Array();
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(circuit->get_mutex());
+
+  PackedFloat64Array arr;
+  for (const auto &kv : trackers) {
+    const playback_tracker_t &tracker = kv.value;
+    if (tracker.candidate_count == 0) {
+      arr.push_back(0.0);
+      continue;
+    }
+    arr.push_back(1.0 - (double)tracker.event_count / (double)tracker.candidate_count);
+  }
+  return arr;
+}
+
+bool AudioStreamTapSimulator::playback_tracker_t::encode_change(AudioFrame &r_frame, int threshold, float hysteresis) {
+  if (hysteresis > 0.0f) {
+    //schmitt trigger: only flip once the input clears the band around 0
+    if (r_frame.left > hysteresis) {
+      schmitt_state.left = 1.0f;
+    } else if (r_frame.left < -hysteresis) {
+      schmitt_state.left = -1.0f;
+    }
+
+    if (r_frame.right > hysteresis) {
+      schmitt_state.right = 1.0f;
+    } else if (r_frame.right < -hysteresis) {
+      schmitt_state.right = -1.0f;
+    }
+
+    r_frame = schmitt_state;
+  }
+
+  tap_frame quantized(r_frame);
+
+  //compare against the last frame that was pushed, not the last frame seen, so
+  //slow drift still gets through once it adds up past the threshold
+  if (has_sent && quantized.delta(last_sent) <= (uint32_t)threshold) {
+    return false;
+  }
+
+  last_sent = quantized;
+  has_sent = true;
+  return true;
+}
+
+void AudioStreamTapSimulator::playback_tracker_t::reset() {
+  event_count = 0;
+  candidate_count = 0;
+  schmitt_state = AudioFrame(-1.0f, -1.0f);
+  has_sent = false;
+  skip_phase = 0;
+  anti_alias.reset();
+}
+
 void AudioStreamTapSimulatorPlayback::_bind_methods() {};
 
 int AudioStreamTapSimulatorPlayback::mix_debug(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
@@ -324,7 +1349,7 @@ int AudioStreamTapSimulatorPlayback::mix_debug(AudioFrame *p_buffer, float p_rat
     return p_frames;
   }
 
-  Ref<AudioStreamPlayback> playback = owner->trackers[owner->debug_input_override].playback;
+  Ref<AudioStreamPlayback> playback = get_trackers_internal()[owner->debug_input_override].playback;
 
   if (!playback.is_valid()) {
     for (int i = 0; i < p_frames; i++) {
@@ -358,12 +1383,14 @@ int AudioStreamTapSimulatorPlayback::mix_in(float p_rate_scale, int p_frames) {
 	int todo = p_frames;
   int rolling_time = current_time;
 
+  const bool change_driven = owner->input_encoding == AudioStreamTapSimulator::INPUT_ENCODING_CHANGE;
+
 	bool any_active = false;
 	while (todo) {
 		int to_mix = MIN(todo, MIX_BUFFER_SIZE);
 
 		bool first = true;
-		for (auto &kv : owner->trackers) {
+		for (auto &kv : get_trackers_internal()) {
       tap_label_t label = kv.key;
 			auto &tracker = kv.value;
 			if (tracker.playback->is_playing()) {
@@ -374,14 +1401,55 @@ int AudioStreamTapSimulatorPlayback::mix_in(float p_rate_scale, int p_frames) {
 					any_active = true;
 				}
 
+        int threshold = owner->input_threshold;
+        float hysteresis = 0.0f;
+        if (change_driven) {
+          const int *threshold_override = owner->input_thresholds.getptr(label);
+          if (threshold_override) {
+            threshold = *threshold_override;
+          }
+          const float *hysteresis_override = owner->input_hysteresis.getptr(label);
+          if (hysteresis_override) {
+            hysteresis = *hysteresis_override;
+          }
+        }
+
+        int skip = get_sample_skip_internal();
+        const int *decimation = owner->input_decimation.getptr(label);
+        if (decimation) {
+          skip *= *decimation;
+        }
+
         tracker.playback->mix(mix_buffer, p_rate_scale, to_mix);
-        for (int j = 0; j < to_mix; j += owner->sample_skip) {  
-          //input circuit events here.
-          tap_time_t time = rolling_time + (j * p_rate_scale) * owner->tick_rate;
-          owner->circuit->push_event(time, mix_buffer[j], label);
+
+        //band limit inputs decimated below the event rate, for the rate they
+        //are actually sampled at
+        if (owner->antialias_inputs && decimation && *decimation > 1) {
+          if (tracker.anti_alias.designed_for != skip) {
+            tracker.anti_alias.design(skip);
+          }
+          tracker.anti_alias.process_block(mix_buffer, to_mix);
         }
 
-        tracker.event_count += to_mix / owner->sample_skip;
+        input_run.clear();
+        int j = tracker.skip_phase;
+        for (; j < to_mix; j += skip) {  
+          AudioFrame frame = mix_buffer[j];
+          tracker.candidate_count++;
+
+          if (change_driven && !tracker.encode_change(frame, threshold, hysteresis)) {
+            continue;
+          }
+
+          //input circuit events here. They come out sorted, so collect the run
+          //and hand it over in one go.
+          tap_time_t time = rolling_time + (j * p_rate_scale) * get_tick_rate_internal();
+          input_run.push_back(tap_event_t{ time, frame, label, TapPatchBay::COMPONENT_MISSING });
+        }
+        tracker.skip_phase = j - to_mix;
+
+        owner->circuit->push_event_run(label, input_run);
+        tracker.event_count += input_run.size();
 
         //std::cout << "\tincrementing " << tracker.playback.ptr() << " to " << tracker.event_count << std::endl;
 			}
@@ -389,10 +1457,11 @@ int AudioStreamTapSimulatorPlayback::mix_in(float p_rate_scale, int p_frames) {
 		todo -= to_mix;
 
     //update rolling time so the phase of the circuit is correct
-    rolling_time += (to_mix * p_rate_scale) * owner->tick_rate;
+    rolling_time += (to_mix * p_rate_scale) * get_tick_rate_internal();
 	}
 
-	if (!any_active) {
+	//circuits with their own clocks and oscillators keep running on their own
+	if (!any_active && !(offline ? offline_sources_running : owner->sources_running)) {
 		stop();
     ERR_PRINT("AudioStreamTapSimulatorPlayback::mix_in tried to push events with no active input streams.");
 	}
@@ -409,16 +1478,44 @@ int AudioStreamTapSimulatorPlayback::mix_out(AudioFrame *p_buffer, float p_rate_
   bool use_reference = owner->reference_sim.is_valid();
   auto patch_bay = owner->circuit->get_patch_bay();
 
+  //per-block budget. Once it runs out, the outputs hold until the next block.
+  //an offline render has nothing to keep up with, so it runs unbudgeted
+  int events_left = !offline && owner->event_budget > 0 ? owner->event_budget : -1;
+  uint64_t deadline_usec = !offline && owner->time_budget_usec > 0 ? OS::get_singleton()->get_ticks_usec() + owner->time_budget_usec : 0;
+  bool out_of_budget = false;
+  tap_time_t reached_time = current_time;
+  //one count for the whole block, so the deadline is checked every few events
+  //even when each step only has a handful
+  int block_count = 0;
+
+  if (use_reference) {
+    const int skip = get_sample_skip_internal();
+    reference_block.prepare(problem.size(), solution.size(), (p_frames + skip - 1) / skip);
+    reference_block.first_frame = frames_mixed;
+    reference_block.frame_stride = skip;
+  }
+
   for (int i = 0; i < p_frames; i++) {
 
-    //fill the problem buffer
-    for (size_t j = 0; j < MIN(owner->input_streams.size(), problem.size()); j++) {
-      problem[j] = patch_bay->get_pin_state(owner->input_streams[j].pid);
+    //fill the problem buffer, only the reference sim reads it
+    if (use_reference && i % get_sample_skip_internal() == 0) {
+      for (size_t j = 0; j < MIN(owner->input_streams.size(), problem.size()); j++) {
+        problem[j] = patch_bay->get_pin_state_internal(owner->input_streams[j].pid);
+      }
     }
 
     //compute the solution
-    if (i % owner->sample_skip == 0) {
-      processed_events_count += owner->circuit->process_to(current_time + (i * p_rate_scale) * owner->tick_rate);
+    if (i % get_sample_skip_internal() == 0 && !out_of_budget) {
+      tap_time_t target_time = current_time + (i * p_rate_scale) * get_tick_rate_internal();
+      int count_before = block_count;
+      reached_time = owner->circuit->process_to_internal(target_time, events_left, deadline_usec, block_count);
+      int count = block_count - count_before;
+      processed_events_count += count;
+
+      if (events_left >= 0) {
+        events_left -= count;
+      }
+      out_of_budget = reached_time < target_time;
     }
 
     //zero out the buffer before summing to avoid noise from previous frames
@@ -430,8 +1527,9 @@ int AudioStreamTapSimulatorPlayback::mix_out(AudioFrame *p_buffer, float p_rate_
     }
 
     //compute the problem/solution error
-    if (use_reference && i % owner->sample_skip == 0) {
-      owner->reference_sim->measure_error_internal(solution, problem, 1.0 / (mix_rate * (double)p_rate_scale));
+    //a held output isn't the circuit's answer, so don't score it
+    if (use_reference && !out_of_budget && i % get_sample_skip_internal() == 0) {
+      reference_block.push_row(problem.ptr(), solution.ptr());
     }
 
     //fill the audio buffer
@@ -440,38 +1538,138 @@ int AudioStreamTapSimulatorPlayback::mix_out(AudioFrame *p_buffer, float p_rate_
       p_buffer[i] += solution[j];
     }
   }
+
+  if (use_reference) {
+    owner->reference_sim->measure_block_internal(reference_block, 1.0 / (mix_rate * (double)p_rate_scale));
+  }
+
+  tap_time_t block_end_time = current_time + ((p_frames - 1) * p_rate_scale) * get_tick_rate_internal();
+  if (offline) {
+    //lag and misses describe live playback
+  } else if (out_of_budget) {
+    owner->deadline_miss_count++;
+    owner->backlog_depth = patch_bay->get_event_count();
+    owner->simulation_lag = block_end_time > reached_time ? block_end_time - reached_time : 0;
+  } else {
+    owner->backlog_depth = 0;
+    owner->simulation_lag = 0;
+  }
+
   return p_frames;
 }
 
 int AudioStreamTapSimulatorPlayback::mix_stats(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
-  
-  AudioFrame avg;
+  if (!owner->calculate_stats) {
+    return p_frames;
+  }
+
+  owner->output_stats.add_block(p_buffer, p_frames);
+
+  //running on the audio thread, so leave the reading to the main thread
+  owner->stats_frames_pending += p_frames;
+  if (owner->stats_frames_pending >= owner->stats_interval * mix_rate) {
+    owner->stats_frames_pending = 0;
+    callable_mp(owner, &AudioStreamTapSimulator::publish_output_stats).call_deferred();
+  }
+
+  return p_frames;
+}
+
+int AudioStreamTapSimulatorPlayback::mix_shared(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
+  if (!reader_playing || owner->shared_driver.is_null()) {
+    return 0;
+  }
+
+  if (!owner->circuit->get_mutex().try_lock()) {
+    TapMonitors::record_dropped_block();
+    return p_frames;
+  }
+
+  const uint64_t capacity = AudioStreamTapSimulator::BROADCAST_BUFFER_SIZE;
+  const uint64_t mask = capacity - 1;
+
+  //fell further behind the other readers than the buffer holds, rejoin live
+  if (owner->broadcast_written > read_cursor + capacity) {
+    read_cursor = owner->broadcast_written;
+  }
+
+  //whoever needs frames first advances the simulation, everyone else just reads
+  uint64_t needed = read_cursor + p_frames;
+  while (owner->broadcast_written < needed) {
+    uint64_t offset = owner->broadcast_written & mask;
+    int to_mix = (int)MIN(needed - owner->broadcast_written, capacity - offset);
+    to_mix = MIN(to_mix, (int)(capacity / 2));
+
+    owner->shared_driver->mix_simulation(owner->broadcast_buffer.ptr() + offset, p_rate_scale, to_mix);
+    owner->broadcast_written += to_mix;
+  }
 
   for (int i = 0; i < p_frames; i++) {
-    avg += p_buffer[i];
+    p_buffer[i] = owner->broadcast_buffer[(read_cursor + i) & mask];
   }
+  read_cursor += p_frames;
 
-  avg /= (float)p_frames;
+  owner->circuit->get_mutex().unlock();
 
-  std::cout << "AudioStreamTapSimulatorPlayback::mix_stats: " << avg.left << ", " << avg.right << std::endl;
-  
   return p_frames;
 }
 
 int AudioStreamTapSimulatorPlayback::mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
+  if (shared_reader) {
+    return mix_shared(p_buffer, p_rate_scale, p_frames);
+  }
+  return mix_simulation(p_buffer, p_rate_scale, p_frames);
+}
+
+int AudioStreamTapSimulatorPlayback::mix_simulation(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
   if (!owner->circuit->get_mutex().try_lock()) {
+    TapMonitors::record_dropped_block();
     return p_frames;
   }
 
+  uint64_t mix_start_usec = OS::get_singleton()->get_ticks_usec();
+  uint64_t stage_start_nsec = tap_histogram_t::now_nsec();
+  const uint64_t block_start_nsec = stage_start_nsec;
+
+  //time each stage into its histogram. An offline render would skew the live
+  //latency distribution, so it isn't recorded
+  auto end_stage = [&](int stage) {
+    uint64_t now_nsec = tap_histogram_t::now_nsec();
+    if (!offline) {
+      owner->stage_latency[stage].record(now_nsec - stage_start_nsec);
+    }
+    stage_start_nsec = now_nsec;
+  };
+
   mix_debug(p_buffer, p_rate_scale, p_frames);
+  end_stage(AudioStreamTapSimulator::MIX_STAGE_DEBUG);
 
   mix_in(p_rate_scale, p_frames);
+  end_stage(AudioStreamTapSimulator::MIX_STAGE_IN);
 
   mix_out(p_buffer, p_rate_scale, p_frames);
+  end_stage(AudioStreamTapSimulator::MIX_STAGE_OUT);
 
   mix_stats(p_buffer, p_rate_scale, p_frames);
+  end_stage(AudioStreamTapSimulator::MIX_STAGE_STATS);
+
+  uint64_t block_nsec = stage_start_nsec - block_start_nsec;
+  double deadline_nsec = p_frames * 1000000000.0 / mix_rate;
+  if (!offline) {
+    owner->stage_latency[AudioStreamTapSimulator::MIX_STAGE_TOTAL].record(block_nsec);
+    if (deadline_nsec > 0.0) {
+      owner->block_utilization.record((uint64_t)(block_nsec * 1000000.0 / deadline_nsec));
+    }
+  }
 
-  current_time += (p_frames * p_rate_scale) * owner->tick_rate;
+  current_time += (p_frames * p_rate_scale) * get_tick_rate_internal();
+  frames_mixed += p_frames;
+
+  uint64_t mix_usec = OS::get_singleton()->get_ticks_usec() - mix_start_usec;
+  if (!offline) {
+    owner->update_quality_internal(mix_usec, p_frames * 1000000.0 / mix_rate);
+    TapMonitors::record_mix(mix_usec, owner->simulation_lag);
+  }
 
   owner->circuit->get_mutex().unlock();
   
@@ -479,25 +1677,125 @@ int AudioStreamTapSimulatorPlayback::mix(AudioFrame *p_buffer, float p_rate_scal
 }
 
 void AudioStreamTapSimulatorPlayback::start(double p_from_pos) {
+  if (shared_reader) {
+    if (owner->circuit.is_null()) {
+      return;
+    }
+
+    //set_shared_simulation swaps the driver under this lock
+    std::lock_guard<std::recursive_mutex> lock(owner->circuit->get_mutex());
+    if (owner->shared_driver.is_null()) {
+      return;
+    }
+
+    if (!owner->shared_driver->is_playing()) {
+      owner->shared_driver->start(p_from_pos);
+    }
+
+    if (!reader_playing || reader_generation != owner->shared_generation) {
+      reader_playing = true;
+      reader_generation = owner->shared_generation;
+      owner->shared_readers_playing++;
+    }
+
+    //join at the live edge
+    read_cursor = owner->broadcast_written;
+    return;
+  }
+
   if (owner->can_simulate()) {
     current_time = 0.0;
+    frames_mixed = 0;
+    if (!offline) {
+      owner->load = 0.0;
+    }
 
-    for (auto kv : owner->trackers) {
-      kv.value.event_count = 0;
+    for (auto &kv : get_trackers_internal()) {
+      kv.value.reset();
       kv.value.playback->start(p_from_pos);
     }
+
+    //time starts over, so anything still queued or remembered from the last run is stale
+    std::lock_guard<std::recursive_mutex> lock(owner->circuit->get_mutex());
+    owner->circuit->get_patch_bay()->clear_events_internal();
+    owner->circuit->get_network()->reset_memory_internal();
+    bool running = owner->circuit->start_sources(current_time) > 0;
+    if (offline) {
+      offline_sources_running = running;
+    } else {
+      owner->sources_running = running;
+    }
   }
 }
 
 void AudioStreamTapSimulatorPlayback::stop() {
+  if (shared_reader) {
+    if (owner->circuit.is_null()) {
+      return;
+    }
+
+    //same lock as start, so the count and the driver can't change underneath
+    std::lock_guard<std::recursive_mutex> lock(owner->circuit->get_mutex());
+    if (!reader_playing) {
+      return;
+    }
+
+    reader_playing = false;
+    if (reader_generation != owner->shared_generation) {
+      return; //counted against a driver that is already gone
+    }
+    owner->shared_readers_playing--;
+
+    //the simulation keeps running as long as anyone is listening
+    if (owner->shared_readers_playing <= 0 && owner->shared_driver.is_valid()) {
+      owner->shared_readers_playing = 0;
+      owner->shared_driver->stop();
+    }
+    return;
+  }
+
+  if (offline) {
+    for (auto &kv : offline_trackers) {
+      kv.value.playback->stop();
+    }
+    offline_sources_running = false;
+    return;
+  }
+
   if (owner->is_simulating()) {
     for (auto kv : owner->trackers) {
       kv.value.playback->stop();
     }
   }
+  owner->sources_running = false;
 }
 
 bool AudioStreamTapSimulatorPlayback::is_playing() const {
+  if (shared_reader) {
+    return reader_playing && owner->is_simulating();
+  }
+  if (offline) {
+    if (offline_sources_running) {
+      return true;
+    }
+    for (const auto &kv : offline_trackers) {
+      if (kv.value.playback->is_playing()) {
+        return true;
+      }
+    }
+    return false;
+  }
   return owner->is_simulating();
 }
 
+void AudioStreamTapSimulatorPlayback::set_mix_rate_internal(double p_mix_rate) {
+  ERR_FAIL_COND(p_mix_rate <= 0.0);
+  mix_rate = p_mix_rate;
+
+  for (auto &kv : get_trackers_internal()) {
+    AudioStreamPrimitivePlayback *primitive = Object::cast_to<AudioStreamPrimitivePlayback>(kv.value.playback.ptr());
+    if (primitive) {
+      primitive->set_mix_rate_internal((size_t)p_mix_rate);
+    }
+  }
+}
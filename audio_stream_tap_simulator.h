@@ -6,8 +6,12 @@
 
 #include "tap_circuit_types.h"
 #include "tap_circuit.h"
+#include "tap_dsp.h"
+#include "tap_histogram.h"
 #include "reference_sim.h"
 
+class AudioStreamTapSimulatorPlayback;
+
 /**
  * @brief A TapCircuit driver that maps AudioStreams to input pids for input,
  * and sums output from output pids.
@@ -25,12 +29,61 @@
  * @param tick_rate Multiplies the number of real samples passed to time passed 
  * in the circuit.
  *
+ * @param input_encoding Whether every `sample_skip`-th frame becomes an event,
+ * or only frames that moved far enough from the last pushed frame.
+ * @param input_threshold Default change threshold, in `tap_frame` units summed
+ * over both channels, for `INPUT_ENCODING_CHANGE`.
+ * @param input_thresholds Per-pid overrides of `input_threshold`.
+ * @param input_hysteresis Per-pid Schmitt trigger half-width. Pids listed here
+ * are squared to -1/1 before encoding; the level only flips once the input
+ * crosses past +/- the hysteresis.
+ *
+ * @param input_decimation Per-pid factor multiplying `sample_skip`, so slow
+ * control signals can be fed at a fraction of the event rate.
+ * @param antialias_inputs Low pass inputs with an `input_decimation` above 1
+ * before they are sampled into events. Other inputs are left alone.
+ *
+ * @param event_budget Maximum events processed per mixed block, 0 for
+ * unlimited.
+ * @param time_budget_usec Maximum wall time spent processing events per mixed
+ * block, 0 for unlimited. Outputs hold their last state for the rest of a
+ * block that runs out of budget, and the backlog carries into the next one.
+ * @param deadline_miss_count Blocks that ran out of budget.
+ * @param backlog_depth Events left pending at the end of the last block that
+ * ran out of budget, 0 once caught up.
+ * @param simulation_lag Ticks the circuit trailed behind the end of the last
+ * mixed block.
+ *
+ * @param adaptive_quality Watch how long each block takes to simulate against
+ * how long it lasts, and trade event rate for headroom when the circuit falls
+ * behind. Each quality level doubles the effective `sample_skip` and, with
+ * `adaptive_scale_tick_rate`, halves the effective `tick_rate`.
+ * @param adaptive_high_load Smoothed load (simulation time / block time) above
+ * which the quality level goes up.
+ * @param adaptive_low_load Smoothed load below which the quality level comes
+ * back down.
+ * @param max_quality_level Highest level the controller may reach.
+ *
+ * @param shared_simulation Run one simulation for every playback of this
+ * stream. The simulation writes into a broadcast buffer, and each playback
+ * reads it with its own cursor, so several players cost one simulation. The
+ * simulation advances at the rate scale of whichever playback needs frames
+ * first.
+ *
  * @param trackers Internal state for tracking playback progress.
  */
 class AudioStreamTapSimulator : public AudioStream {
   GDCLASS(AudioStreamTapSimulator, AudioStream);
   friend class AudioStreamTapSimulatorPlayback;
 
+public:
+  enum InputEncoding {
+    INPUT_ENCODING_SAMPLED,
+    INPUT_ENCODING_CHANGE,
+  };
+
+private:
+
   struct stream_pid_t {
     Ref<AudioStream> stream;
     tap_label_t pid;
@@ -47,14 +100,139 @@ class AudioStreamTapSimulator : public AudioStream {
   int sample_skip = 2;
   int tick_rate = 1024;
 
+  InputEncoding input_encoding = INPUT_ENCODING_SAMPLED;
+  int input_threshold = 64;
+  HashMap<tap_label_t, int> input_thresholds;
+  HashMap<tap_label_t, float> input_hysteresis;
+
+  HashMap<tap_label_t, int> input_decimation;
+  bool antialias_inputs = false;
+
+  int event_budget = 0;
+  int time_budget_usec = 0;
+  int64_t deadline_miss_count = 0;
+  int64_t backlog_depth = 0;
+  int64_t simulation_lag = 0;
+
+  //the circuit has self-scheduling sources running, so it plays without input streams
+  bool sources_running = false;
+
+  static constexpr int MAX_QUALITY_LEVEL = 8;
+
+  bool adaptive_quality = false;
+  bool adaptive_scale_tick_rate = false;
+  float adaptive_high_load = 0.85f;
+  float adaptive_low_load = 0.5f;
+  int max_quality_level = 4;
+
+  //controller state
+  int quality_level = 0;
+  double load = 0.0;
+  //positive while overloaded, negative while underloaded, in blocks
+  int blocks_out_of_band = 0;
+  int64_t quality_raise_count = 0;
+  int64_t quality_restore_count = 0;
+
+  //`sample_skip` and `tick_rate` after the quality level is applied. These
+  //are what playback actually runs at.
+  int effective_sample_skip = 2;
+  int effective_tick_rate = 1024;
+
+  //clamp the quality level to the current settings and recompute the
+  //effective rates. Every setter that affects them goes through here.
+  void update_effective_rates_internal();
+
+  /**
+   * @brief Feed the controller one block's simulation time and duration.
+   * Called by the playback with the circuit locked.
+   */
+  void update_quality_internal(uint64_t elapsed_usec, double block_usec);
+
+  void emit_quality_changed(int level, int new_sample_skip, int new_tick_rate);
+
+  //must be a power of 2
+  static constexpr uint64_t BROADCAST_BUFFER_SIZE = 8192;
+
+  bool shared_simulation = false;
+  Ref<AudioStreamTapSimulatorPlayback> shared_driver;
+  LocalVector<AudioFrame> broadcast_buffer;
+  //total frames the shared simulation has written to `broadcast_buffer`
+  uint64_t broadcast_written = 0;
+  int shared_readers_playing = 0;
+  //bumped whenever the shared driver is dropped, so readers counted against an
+  //old driver don't touch the new one's count
+  uint64_t shared_generation = 0;
+
+  /**
+   * @brief Set up trackers for the input streams and build a playback that
+   * drives the circuit itself. An offline playback gets trackers and rate
+   * settings of its own, leaving the live ones alone.
+   */
+  Ref<AudioStreamTapSimulatorPlayback> instantiate_simulation_internal(bool offline = false);
+
+  Dictionary last_render_stats;
+
+  enum MixStage {
+    MIX_STAGE_DEBUG,
+    MIX_STAGE_IN,
+    MIX_STAGE_OUT,
+    MIX_STAGE_STATS,
+    MIX_STAGE_TOTAL,
+    MIX_STAGE_COUNT,
+  };
+
+  //recorded by the audio thread, read and reset from anywhere without the lock
+  tap_histogram_t stage_latency[MIX_STAGE_COUNT];
+  //each block's wall time over its duration, in parts per million
+  tap_histogram_t block_utilization;
+
+  /**
+   * @brief Write stereo frames as a 16-bit PCM WAV file.
+   */
+  static Error write_wav_internal(const String &path, const PackedVector2Array &frames, int mix_rate);
+
   struct playback_tracker_t {
     Ref<AudioStreamPlayback> playback;
-    size_t event_count;
+    size_t event_count = 0;
+    //frames that could have become events, had every one been pushed
+    size_t candidate_count = 0;
+
+    //change encoder state
+    tap_frame last_sent;
+    AudioFrame schmitt_state = AudioFrame(-1.0f, -1.0f);
+    bool has_sent = false;
+
+    //frames left over from the last chunk before the next sample is due, so
+    //skips that don't divide the chunk size keep their phase
+    int skip_phase = 0;
+    tap_anti_alias_t anti_alias;
+
+    /**
+     * @brief Run `r_frame` through the change encoder. Returns true if it
+     * should be pushed as an event, in which case `r_frame` holds the
+     * (possibly squared) state to push.
+     */
+    bool encode_change(AudioFrame &r_frame, int threshold, float hysteresis);
+    void reset();
   };
 
   HashMap<tap_label_t,playback_tracker_t> trackers;
 
-  bool calculate_stats = true;
+  bool calculate_stats = false;
+  double stats_interval = 1.0;
+
+  tap_stats_accumulator_t output_stats;
+  //audio thread only, frames mixed since the last publish was scheduled
+  int64_t stats_frames_pending = 0;
+  //main thread only
+  tap_stats_accumulator_t::snapshot_t last_stats_snapshot;
+  Dictionary last_output_stats;
+
+  /**
+   * @brief Turn the output totals since the last call into window stats and
+   * emit `output_stats_updated`. Deferred to the main thread by the playback.
+   */
+  void publish_output_stats();
 
 protected:
   static void _bind_methods();
@@ -81,6 +259,111 @@ public:
   int get_tick_rate() const;
   void set_tick_rate(int tick_rate);
 
+  InputEncoding get_input_encoding() const;
+  void set_input_encoding(InputEncoding encoding);
+
+  int get_input_threshold() const;
+  void set_input_threshold(int threshold);
+
+  TypedDictionary<tap_label_t, int> get_input_thresholds() const;
+  void set_input_thresholds(const TypedDictionary<tap_label_t, int> &thresholds);
+
+  TypedDictionary<tap_label_t, float> get_input_hysteresis() const;
+  void set_input_hysteresis(const TypedDictionary<tap_label_t, float> &hysteresis);
+
+  TypedDictionary<tap_label_t, int> get_input_decimation() const;
+  void set_input_decimation(const TypedDictionary<tap_label_t, int> &decimation);
+
+  bool get_antialias_inputs() const;
+  void set_antialias_inputs(bool antialias);
+
+  int get_event_budget() const;
+  void set_event_budget(int budget);
+
+  int get_time_budget_usec() const;
+  void set_time_budget_usec(int budget_usec);
+
+  int64_t get_deadline_miss_count() const;
+  int64_t get_backlog_depth() const;
+  int64_t get_simulation_lag() const;
+
+  /**
+   * @brief Zero `deadline_miss_count`, `backlog_depth` and `simulation_lag`.
+   */
+  void reset_deadline_stats();
+
+  /**
+   * @brief Latency histograms of the mix pipeline.
+   *
+   * Keys "mix_debug", "mix_in", "mix_out", "mix_stats" and "total" hold the
+   * count, mean, p50, p90, p99, p999 and max wall time of that stage per block
+   * in microseconds. "utilization" holds the same percentiles of block wall
+   * time over block duration, where 1.0 means the block just made its
+   * deadline. Offline renders aren't recorded.
+   */
+  Dictionary get_latency_histograms() const;
+  void reset_latency_histograms();
+
+  bool get_calculate_stats() const;
+  void set_calculate_stats(bool enabled);
+
+  double get_stats_interval() const;
+  void set_stats_interval(double seconds);
+
+  /**
+   * @brief The most recently published output stats: "frames", and per
+   * channel "dc_offset", "rms" and "peak" as Vector2s over that window.
+   */
+  Dictionary get_output_stats() const;
+
+  bool get_adaptive_quality() const;
+  void set_adaptive_quality(bool enabled);
+
+  bool get_adaptive_scale_tick_rate() const;
+  void set_adaptive_scale_tick_rate(bool enabled);
+
+  float get_adaptive_high_load() const;
+  void set_adaptive_high_load(float load);
+
+  float get_adaptive_low_load() const;
+  void set_adaptive_low_load(float load);
+
+  int get_max_quality_level() const;
+  void set_max_quality_level(int level);
+
+  int get_quality_level() const;
+  double get_load() const;
+  int64_t get_quality_raise_count() const;
+  int64_t get_quality_restore_count() const;
+  int get_effective_sample_skip() const;
+  int get_effective_tick_rate() const;
+
+  bool get_shared_simulation() const;
+  void set_shared_simulation(bool shared);
+
+  /**
+   * @brief Simulate `seconds` of output as fast as possible, without the audio
+   * server driving it.
+   *
+   * Pulls the input streams and runs the circuit through its own playback at
+   * the AudioServer mix rate, so it works under `--headless`. Live playback
+   * must be stopped first. The render uses its own input trackers and runs
+   * at full quality with no per-block budgets, without touching the live
+   * trackers, quality level or settings.
+   *
+   * @param seconds Length of output to render
+   * @param path If not empty, also write the output to this path as a 16-bit
+   * WAV file
+   * @return The rendered output frames
+   */
+  PackedVector2Array render_offline(double seconds, const String &path = String());
+
+  /**
+   * @brief Frames, events, wall time and realtime factor of the last
+   * `render_offline` call.
+   */
+  Dictionary get_last_render_stats() const;
+
   /**
    * @brief Returns true if all tracked playbacks are playing.
    */
@@ -97,9 +380,23 @@ public:
    */
   PackedInt64Array get_event_counts() const;
 
+  /**
+   * @brief Returns, in the same order as `get_event_counts`, the fraction of
+   * candidate input frames that the input encoding did not push. Always 0 for
+   * `INPUT_ENCODING_SAMPLED`.
+   */
+  PackedFloat64Array get_event_reduction_ratios() const;
+
+  /**
+   * @brief Without `shared_simulation`, build a playback that takes over the
+   * inputs and drives the circuit. With it, build a reader of the shared
+   * simulation, creating the simulation on first use.
+   */
   virtual Ref<AudioStreamPlayback> instantiate_playback() override;
 };
 
+VARIANT_ENUM_CAST(AudioStreamTapSimulator::InputEncoding);
+
 /**
  * @brief Drives a TapCircuit by pushing events from `owner->input_streams` to
  * and reads state from `owner->output_pids` to generate audio.
@@ -111,6 +408,8 @@ public:
  *
  * @param debug_input_pids Pids that can be piped directly to the output
  * instead of through the circuit. Good for toggling.
+ * @param input_run Scratch buffer for the sorted run of events one input
+ * stream produces per chunk.
  *
  * @param problem `mix_out`'s input pids state before each circuit execution.
  * Used to validate circuit behavior against `owner->reference_sim`.
@@ -120,6 +419,9 @@ public:
  * delta time when incrementing `owner->reference_sim`'s error.
  *
  * @param processed_events_count The number of events processed by the circuit.
+ *
+ * @param shared_reader If true, this playback only reads
+ * `owner->broadcast_buffer` from `read_cursor` instead of simulating.
  */
 class AudioStreamTapSimulatorPlayback : public AudioStreamPlaybackResampled {
   GDCLASS(AudioStreamTapSimulatorPlayback, AudioStreamPlaybackResampled);
@@ -137,10 +439,41 @@ class AudioStreamTapSimulatorPlayback : public AudioStreamPlaybackResampled {
 
   HashSet<tap_label_t> debug_input_pids;
 
+  //scratch run of events for one input stream, handed to the circuit in one go
+  LocalVector<tap_event_t> input_run;
+
   LocalVector<AudioFrame> problem;
   LocalVector<AudioFrame> solution;
+
+  //scored rows of the current block, handed to the reference sim in one go
+  tap_reference_block_t reference_block;
+  //frames mixed since `start`, to timestamp reference divergence
+  uint64_t frames_mixed = 0;
   double mix_rate = 44100.0;
 
+  bool shared_reader = false;
+  bool reader_playing = false;
+  //owner's `shared_generation` when this reader was counted as playing
+  uint64_t reader_generation = 0;
+  uint64_t read_cursor = 0;
+
+  //an offline render's own trackers and rates, snapshotted at full quality
+  bool offline = false;
+  bool offline_sources_running = false;
+  HashMap<tap_label_t, AudioStreamTapSimulator::playback_tracker_t> offline_trackers;
+  int offline_sample_skip = 1;
+  int offline_tick_rate = 1;
+
+  HashMap<tap_label_t, AudioStreamTapSimulator::playback_tracker_t> &get_trackers_internal() {
+    return offline ? offline_trackers : owner->trackers;
+  }
+  int get_sample_skip_internal() const {
+    return offline ? offline_sample_skip : owner->effective_sample_skip;
+  }
+  int get_tick_rate_internal() const {
+    return offline ? offline_tick_rate : owner->effective_tick_rate;
+  }
+
 protected:
   static void _bind_methods();
 
@@ -155,24 +488,43 @@ public:
 
   /**
    * @brief Mix `owner->input_streams` into the circuit at their target pids.
+   *
+   * With `INPUT_ENCODING_CHANGE`, frames are only pushed once they differ
+   * from the last pushed frame by more than the stream's threshold.
    */
   int mix_in(float p_rate_scale, int p_frames);
 
   /**
    * @brief Sum the states of `owner->output_pids` into `p_buffer` for each 
    * audio frame.
+   *
+   * Respects `owner->event_budget` and `owner->time_budget_usec`, except in
+   * an offline render. Once the budget runs out, the remaining frames hold the
+   * current output state.
    */
   int mix_out(AudioFrame *p_buffer, float p_rate_scale, int p_frames);
 
   /**
    * @brief Run statistics on mixed outputs if `owner->calculate_stats` is true.
    *
-   * Prints the average level for each channel to std::cout.
+   * Only adds the block to `owner->output_stats`. Every `owner->stats_interval`
+   * seconds, publishing is deferred to the main thread.
    */
   int mix_stats(AudioFrame *p_buffer, float p_rate_scale, int p_frames);
 
-	/**
+  /**
    * @brief Schedule and call all the other mix methods.
+   */
+  int mix_simulation(AudioFrame *p_buffer, float p_rate_scale, int p_frames);
+
+  /**
+   * @brief Copy frames out of the shared broadcast buffer, advancing the
+   * shared simulation first if no other reader has got this far yet.
+   */
+  int mix_shared(AudioFrame *p_buffer, float p_rate_scale, int p_frames);
+
+	/**
+   * @brief `mix_shared` for shared readers, `mix_simulation` otherwise.
    */
 	virtual int mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) override;
 
@@ -194,6 +546,12 @@ public:
    */
 	virtual bool is_playing() const override;
 
+  /**
+   * @brief Mix at `p_mix_rate` rather than the AudioServer mix rate, for
+   * callers that pull frames themselves. AudioStreamPrimitive inputs follow.
+   */
+  void set_mix_rate_internal(double p_mix_rate);
+
 	AudioStreamTapSimulatorPlayback() = default;
 	~AudioStreamTapSimulatorPlayback() = default;
 };
\ No newline at end of file
@@ -60,22 +60,34 @@ destination queue.
  to solver
 `pin_count` : number of pins this component has. If variable, set to 0.
 `solver` : function pointer to the solver function for this type
+`parameters` : constants the solver reads, like a clock's period. Their meaning
+ is up to the solver.
+`self_scheduling` : the solver wakes itself by sending events to one of its own
+ sensitive pins, so those events are not filtered out as bounces.
+`memory_size` : slots of `S` each component of this type keeps between solves.
+ The solver gets them as `memory`, or nullptr if there are none.
+`solver_slot` : where calls to `solver` are counted, resolved once when the
+ solver is set. -1 if nobody counts them.
 */
-template <typename T, typename ComponentID, typename EventT, typename QueueT>
+template <typename S, typename T, typename ComponentID, typename EventT, typename QueueT>
 struct circuit_component_type_t {
-	using solver_t = void (*)(const Vector<EventT> &state, QueueT &queue, T current_time, ComponentID cid);
+	using solver_t = void (*)(const Vector<EventT> &state, QueueT &queue, T current_time, ComponentID cid, const circuit_component_type_t &type, S *memory);
 
 	StringName name;
 	Vector<int> sensitive;
 	int pin_count = -1;
 	//state vector corresponds to sensitive pins
 	solver_t solver = nullptr;
+	Vector<float> parameters;
+	bool self_scheduling = false;
+	int memory_size = 0;
+	int solver_slot = -1;
 };
 
 /*
 Define a component instance in a circuit. Has a type, which defines how to
 handle the component's state. Components also connect to pins via `PinID`, and
-may contain an internal memory of type `S`- the same type as the state in the
+may keep an internal memory of type `S`- the same type as the state in the
 events that the component processes.
 
 `A` is the component type identifier, of which `circuit_component_type_t` is an
@@ -86,16 +98,18 @@ struct circuit_component_t {
 	/*
 	What is this component's name, pinout, and solver.
 	*/
-	circuit_component_type_t<T, ComponentID, EventT, QueueT> component_type;
+	circuit_component_type_t<S, T, ComponentID, EventT, QueueT> component_type;
 	/*
 	The pin ids connected to this component. Since pins store their last event,
 	this also defines the state.
 	*/
 	Vector<PinID> pins;
 	/*
-	The component's internal memory. Currently unused.
+	Where the component's `component_type.memory_size` slots start in the
+	network's memory arena. Components share one contiguous arena rather than
+	each owning an allocation.
 	*/
-	Vector<S> memory;
+	uint32_t memory_offset = 0;
 
 	template <typename F, typename... X>
 	inline void for_each_sensitive(F &&func, X &&...varargs) const {
@@ -4,8 +4,9 @@
 
 #include "reference_sim.h"
 
-// Define the static registry
+// Define the static registries
 HashMap<StringName, ReferenceErrorFunc> ReferenceSim::reference_registry;
+HashMap<StringName, ReferenceBlockFunc> ReferenceSim::reference_block_registry;
 
 void ReferenceSim::_bind_methods() {
   ClassDB::bind_method(D_METHOD("get_reference_sim_name"), &ReferenceSim::get_reference_sim_name);
@@ -31,6 +32,16 @@ void ReferenceSim::_bind_methods() {
   ClassDB::bind_method(D_METHOD("measure_error", "solution", "problem"), &ReferenceSim::measure_error);
   ClassDB::bind_method(D_METHOD("reset"), &ReferenceSim::reset);
 
+  ClassDB::bind_method(D_METHOD("get_window_frames"), &ReferenceSim::get_window_frames);
+  ClassDB::bind_method(D_METHOD("set_window_frames", "frames"), &ReferenceSim::set_window_frames);
+  ADD_PROPERTY(PropertyInfo(Variant::INT, "window_frames", PROPERTY_HINT_RANGE, "1,65536,1,or_greater"), "set_window_frames", "get_window_frames");
+
+  ClassDB::bind_method(D_METHOD("get_divergence_threshold"), &ReferenceSim::get_divergence_threshold);
+  ClassDB::bind_method(D_METHOD("set_divergence_threshold", "threshold"), &ReferenceSim::set_divergence_threshold);
+  ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "divergence_threshold", PROPERTY_HINT_RANGE, "0,1,0.000001,or_greater"), "set_divergence_threshold", "get_divergence_threshold");
+
+  ClassDB::bind_method(D_METHOD("get_error_stats"), &ReferenceSim::get_error_stats);
+
   ClassDB::bind_static_method("ReferenceSim", D_METHOD("initialize_reference_registry"), &ReferenceSim::initialize_reference_registry_internal);
   ClassDB::bind_static_method("ReferenceSim", D_METHOD("deinitialize_reference_registry"), &ReferenceSim::uninitialize_reference_registry_internal);
 }
@@ -47,6 +58,7 @@ void ReferenceSim::set_reference_sim_name(const StringName& new_reference_sim_na
 
   reference_sim_name = new_reference_sim_name;
   reference_sim_func = reference_registry[new_reference_sim_name];
+  reference_block_func = reference_block_registry.has(new_reference_sim_name) ? reference_block_registry[new_reference_sim_name] : nullptr;
 }
 
 Vector2 ReferenceSim::get_total_error() const {
@@ -55,6 +67,37 @@ Vector2 ReferenceSim::get_total_error() const {
 
 void ReferenceSim::reset() {
   total_error = AudioFrame(0, 0);
+
+  for (int c = 0; c < 2; c++) {
+    window_squares[c] = 0.0;
+    window_peak[c] = 0.0f;
+    total_squares[c] = 0.0;
+  }
+  window_count = 0;
+  last_window_rms = AudioFrame(0, 0);
+  last_window_peak = AudioFrame(0, 0);
+  peak_error = AudioFrame(0, 0);
+  rows_measured = 0;
+  first_divergence_frame = -1;
+  for (int i = 0; i < ERROR_HISTOGRAM_BUCKETS; i++) {
+    error_histogram[i] = 0;
+  }
+}
+
+int ReferenceSim::get_window_frames() const {
+  return window_frames;
+}
+
+void ReferenceSim::set_window_frames(int frames) {
+  window_frames = MAX(frames, 1);
+}
+
+float ReferenceSim::get_divergence_threshold() const {
+  return divergence_threshold;
+}
+
+void ReferenceSim::set_divergence_threshold(float threshold) {
+  divergence_threshold = MAX(threshold, 0.0f);
 }
 
 Vector2 ReferenceSim::measure_error(PackedVector2Array solution, PackedVector2Array problem) {
@@ -80,6 +123,139 @@ AudioFrame ReferenceSim::measure_error_internal(const LocalVector<AudioFrame> &s
   return error;
 }
 
+void tap_reference_block_t::prepare(uint32_t new_problem_count, uint32_t new_solution_count, uint32_t new_capacity) {
+  problem_count = new_problem_count;
+  solution_count = new_solution_count;
+  capacity = new_capacity;
+  rows = 0;
+
+  for (int c = 0; c < 2; c++) {
+    if (problem[c].size() < problem_count * capacity) {
+      problem[c].resize(problem_count * capacity);
+    }
+    if (solution[c].size() < solution_count * capacity) {
+      solution[c].resize(solution_count * capacity);
+    }
+    if (error[c].size() < capacity) {
+      error[c].resize(capacity);
+    }
+  }
+
+  //sized exactly, the row functions read the count off the vector
+  if (problem_row.size() != problem_count) {
+    problem_row.resize(problem_count);
+  }
+  if (solution_row.size() != solution_count) {
+    solution_row.resize(solution_count);
+  }
+}
+
+void ReferenceSim::measure_block_internal(tap_reference_block_t &block, double delta_time) {
+  const uint32_t rows = block.rows;
+  if (rows == 0) {
+    return;
+  }
+
+  float *error_l = block.error[0].ptr();
+  float *error_r = block.error[1].ptr();
+
+  if (reference_block_func) {
+    reference_block_func(block, 0, error_l);
+    reference_block_func(block, 1, error_r);
+  } else {
+    //no kernel, so gather each row back into the per-row layout
+    LocalVector<AudioFrame> &problem_row = block.problem_row;
+    LocalVector<AudioFrame> &solution_row = block.solution_row;
+    for (uint32_t r = 0; r < rows; r++) {
+      for (uint32_t j = 0; j < block.problem_count; j++) {
+        problem_row[j] = AudioFrame(block.problem[0][j * block.capacity + r], block.problem[1][j * block.capacity + r]);
+      }
+      for (uint32_t j = 0; j < block.solution_count; j++) {
+        solution_row[j] = AudioFrame(block.solution[0][j * block.capacity + r], block.solution[1][j * block.capacity + r]);
+      }
+      AudioFrame error = reference_sim_func(solution_row, problem_row);
+      error_l[r] = error.left;
+      error_r[r] = error.right;
+    }
+  }
+
+  //branch free reductions first, so they vectorize
+  float abs_sum_l = 0.0f, abs_sum_r = 0.0f;
+  for (uint32_t r = 0; r < rows; r++) {
+    error_l[r] = Math::abs(error_l[r]);
+    error_r[r] = Math::abs(error_r[r]);
+    abs_sum_l += error_l[r];
+    abs_sum_r += error_r[r];
+  }
+  total_error += AudioFrame(abs_sum_l * delta_time, abs_sum_r * delta_time);
+
+  static const float histogram_edges[ERROR_HISTOGRAM_BUCKETS - 1] = { 1e-6f, 1e-5f, 1e-4f, 1e-3f, 1e-2f, 1e-1f, 1.0f };
+
+  //windows can end mid block, so walk the rows once more
+  for (uint32_t r = 0; r < rows; r++) {
+    float l = error_l[r];
+    float e_r = error_r[r];
+
+    window_squares[0] += (double)l * l;
+    window_squares[1] += (double)e_r * e_r;
+    window_peak[0] = MAX(window_peak[0], l);
+    window_peak[1] = MAX(window_peak[1], e_r);
+
+    float larger = MAX(l, e_r);
+    int bucket = 0;
+    while (bucket < ERROR_HISTOGRAM_BUCKETS - 1 && larger >= histogram_edges[bucket]) {
+      bucket++;
+    }
+    error_histogram[bucket]++;
+
+    if (first_divergence_frame < 0 && larger > divergence_threshold) {
+      first_divergence_frame = (int64_t)(block.first_frame + (uint64_t)r * block.frame_stride);
+    }
+
+    if (++window_count >= window_frames) {
+      last_window_rms = AudioFrame(Math::sqrt(window_squares[0] / window_count), Math::sqrt(window_squares[1] / window_count));
+      last_window_peak = AudioFrame(window_peak[0], window_peak[1]);
+      peak_error = AudioFrame(MAX(peak_error.left, window_peak[0]), MAX(peak_error.right, window_peak[1]));
+
+      total_squares[0] += window_squares[0];
+      total_squares[1] += window_squares[1];
+      window_squares[0] = window_squares[1] = 0.0;
+      window_peak[0] = window_peak[1] = 0.0f;
+      window_count = 0;
+    }
+  }
+
+  rows_measured += rows;
+}
+
+Dictionary ReferenceSim::get_error_stats() const {
+  //fold in the window still filling up
+  double squares_l = total_squares[0] + window_squares[0];
+  double squares_r = total_squares[1] + window_squares[1];
+  float peak_l = MAX(peak_error.left, window_peak[0]);
+  float peak_r = MAX(peak_error.right, window_peak[1]);
+
+  Dictionary dict;
+  dict["rows_measured"] = (int64_t)rows_measured;
+  dict["window_rms"] = Vector2(last_window_rms.left, last_window_rms.right);
+  dict["window_peak"] = Vector2(last_window_peak.left, last_window_peak.right);
+  dict["rms"] = rows_measured > 0 ? Vector2(Math::sqrt(squares_l / rows_measured), Math::sqrt(squares_r / rows_measured)) : Vector2();
+  dict["peak"] = Vector2(peak_l, peak_r);
+  dict["first_divergence_frame"] = first_divergence_frame;
+
+  PackedInt64Array histogram;
+  PackedFloat64Array edges;
+  double edge = 0.0;
+  for (int i = 0; i < ERROR_HISTOGRAM_BUCKETS; i++) {
+    histogram.push_back((int64_t)error_histogram[i]);
+    edges.push_back(edge);
+    edge = edge == 0.0 ? 1e-6 : edge * 10.0;
+  }
+  dict["histogram"] = histogram;
+  dict["histogram_edges"] = edges;
+  return dict;
+}
+
 AudioFrame reference_mixer_no_peak(const LocalVector<AudioFrame> &solution, const LocalVector<AudioFrame> &problem) {
 
   if (solution.is_empty()) {
@@ -95,13 +271,39 @@ AudioFrame reference_mixer_no_peak(const LocalVector<AudioFrame> &solution, cons
   return mix - solution[0];
 }
 
+void reference_mixer_no_peak_block(const tap_reference_block_t &block, int channel, float *r_error) {
+  const uint32_t rows = block.rows;
+  const float *problem = block.problem[channel].ptr();
+  const float *solution = block.solution[channel].ptr();
+
+  if (block.solution_count == 0) {
+    for (uint32_t r = 0; r < rows; r++) {
+      r_error[r] = Math::INF;
+    }
+    return;
+  }
+
+  //sum the inputs a whole row of the block at a time
+  for (uint32_t r = 0; r < rows; r++) {
+    r_error[r] = -solution[r];
+  }
+  for (uint32_t j = 0; j < block.problem_count; j++) {
+    const float *input = problem + j * block.capacity;
+    for (uint32_t r = 0; r < rows; r++) {
+      r_error[r] += input[r];
+    }
+  }
+}
+
 void ReferenceSim::initialize_reference_registry_internal() {
   reference_registry["mixer_no_peak"] = reference_mixer_no_peak;
+  reference_block_registry["mixer_no_peak"] = reference_mixer_no_peak_block;
   print_line(vformat("ReferenceSim: Registered %d reference functions.", reference_registry.size()));
 }
 
 void ReferenceSim::uninitialize_reference_registry_internal() {
   reference_registry.clear();
+  reference_block_registry.clear();
 }
 
 
@@ -7,6 +7,59 @@
 
 using ReferenceErrorFunc = AudioFrame(*)(const LocalVector<AudioFrame> &solution,const LocalVector<AudioFrame> &problem);
 
+/**
+ * @brief A block of problem/solution rows for `ReferenceSim::measure_block_internal`,
+ * stored structure-of-arrays so reference kernels run down contiguous floats.
+ *
+ * Channel `c` of problem pid `j` at row `r` lives at
+ * `problem[c][j * capacity + r]`, and the same layout holds for `solution`.
+ * Row `r` is the frame `first_frame + r * frame_stride`.
+ */
+struct tap_reference_block_t {
+  uint32_t rows = 0;
+  uint32_t capacity = 0;
+  uint32_t problem_count = 0;
+  uint32_t solution_count = 0;
+
+  uint64_t first_frame = 0;
+  uint32_t frame_stride = 1;
+
+  LocalVector<float> problem[2];
+  LocalVector<float> solution[2];
+  //kernel output, one signed error per row
+  LocalVector<float> error[2];
+  //one row gathered back into frames, for references without a block kernel
+  LocalVector<AudioFrame> problem_row;
+  LocalVector<AudioFrame> solution_row;
+
+  /**
+   * @brief Empty the block for up to `new_capacity` rows. Only allocates when
+   * the block has to grow.
+   */
+  void prepare(uint32_t new_problem_count, uint32_t new_solution_count, uint32_t new_capacity);
+
+  inline void push_row(const AudioFrame *problems, const AudioFrame *solutions) {
+    if (rows >= capacity) {
+      return;
+    }
+    for (uint32_t j = 0; j < problem_count; j++) {
+      problem[0][j * capacity + rows] = problems[j].left;
+      problem[1][j * capacity + rows] = problems[j].right;
+    }
+    for (uint32_t j = 0; j < solution_count; j++) {
+      solution[0][j * capacity + rows] = solutions[j].left;
+      solution[1][j * capacity + rows] = solutions[j].right;
+    }
+    rows++;
+  }
+};
+
+/**
+ * @brief Block version of a reference function. Writes the signed error of
+ * every row of one channel to `r_error`.
+ */
+using ReferenceBlockFunc = void (*)(const tap_reference_block_t &block, int channel, float *r_error);
+
 /***
  * @brief Wrapper for a reference function to validate TapCircuit behavior.
  * 
@@ -24,6 +77,27 @@ class ReferenceSim : public Resource {
   AudioFrame total_error;
   
   ReferenceErrorFunc reference_sim_func;
+  //null if the reference has no block kernel, then blocks fall back to rows
+  ReferenceBlockFunc reference_block_func = nullptr;
+
+  static constexpr int ERROR_HISTOGRAM_BUCKETS = 8;
+
+  //windowed statistics, fed by `measure_block_internal`
+  int window_frames = 4096;
+  float divergence_threshold = 1e-3f;
+
+  double window_squares[2] = {};
+  float window_peak[2] = {};
+  int window_count = 0;
+  AudioFrame last_window_rms;
+  AudioFrame last_window_peak;
+
+  double total_squares[2] = {};
+  AudioFrame peak_error;
+  uint64_t rows_measured = 0;
+  int64_t first_divergence_frame = -1;
+  //bucket 0 is below 1e-6, each next one a decade up, the last 1 and over
+  uint64_t error_histogram[ERROR_HISTOGRAM_BUCKETS] = {};
 
   protected:
     static void _bind_methods();
@@ -65,5 +139,34 @@ class ReferenceSim : public Resource {
      */
     AudioFrame measure_error_internal(const LocalVector<AudioFrame> &solution, const LocalVector<AudioFrame> &problem, double delta_time);
 
+    /**
+     * @brief Measure a whole block of rows at once and update the windowed
+     * statistics. Each row adds `|error| * delta_time` to `total_error` like
+     * `measure_error_internal` does.
+     *
+     * Uses the reference's block kernel if it has one, and the per-row function
+     * otherwise.
+     */
+    void measure_block_internal(tap_reference_block_t &block, double delta_time);
+
+    int get_window_frames() const;
+    void set_window_frames(int frames);
+
+    float get_divergence_threshold() const;
+    void set_divergence_threshold(float threshold);
+
+    /**
+     * @brief Error statistics from the block API.
+     *
+     * "window_rms" and "window_peak" cover the last complete window of
+     * `window_frames` rows, "rms" and "peak" everything since `reset`.
+     * "histogram" counts rows by their larger channel error in decades from
+     * 1e-6 up to 1, with "histogram_edges" holding the lower edges.
+     * "first_divergence_frame" is the first frame whose error exceeded
+     * `divergence_threshold`, or -1.
+     */
+    Dictionary get_error_stats() const;
+
     static HashMap<StringName, ReferenceErrorFunc> reference_registry;
+    static HashMap<StringName, ReferenceBlockFunc> reference_block_registry;
 };
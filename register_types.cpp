@@ -8,6 +8,10 @@
 #include "reference_sim.h"
 #include "audio_stream_tap_simulator.h"
 #include "audio_stream_primitive.h"
+#include "audio_effect_tap_circuit.h"
+#include "tap_benchmark.h"
+#include "tap_differential_tester.h"
+#include "tap_monitors.h"
 
 void initialize_flex_logic_cpp_2_module(ModuleInitializationLevel p_level) {
 	if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
@@ -18,6 +22,7 @@ void initialize_flex_logic_cpp_2_module(ModuleInitializationLevel p_level) {
 	//correctly.
 	TapComponentType::initialize_solver_registry_internal();
 	ReferenceSim::initialize_reference_registry_internal();
+	TapMonitors::initialize_monitors_internal();
 
 	ClassDB::register_class<TapFrame>();
 	ClassDB::register_class<TapComponentType>();
@@ -30,6 +35,12 @@ void initialize_flex_logic_cpp_2_module(ModuleInitializationLevel p_level) {
 	ClassDB::register_class<AudioStreamTapSimulator>();
 	ClassDB::register_class<AudioStreamTapSimulatorPlayback>();
 	ClassDB::register_class<AudioStreamPrimitive>();
+
+	ClassDB::register_class<AudioEffectTapCircuit>();
+	ClassDB::register_class<AudioEffectTapCircuitInstance>();
+
+	ClassDB::register_class<TapBenchmark>();
+	ClassDB::register_class<TapDifferentialTester>();
 }
 
 void uninitialize_flex_logic_cpp_2_module(ModuleInitializationLevel p_level) {
@@ -37,6 +48,7 @@ void uninitialize_flex_logic_cpp_2_module(ModuleInitializationLevel p_level) {
 		return;
 	}
 
+	TapMonitors::uninitialize_monitors_internal();
 	TapComponentType::uninitialize_solver_registry_internal();
 	ReferenceSim::uninitialize_reference_registry_internal();
 }
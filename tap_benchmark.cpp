@@ -0,0 +1,771 @@
+#include <mutex>
+
+#include "core/io/file_access.h"
+#include "core/io/json.h"
+#include "core/object/class_db.h"
+#include "core/os/memory.h"
+#include "core/os/os.h"
+
+#include "audio_stream_primitive.h"
+#include "audio_stream_tap_simulator.h"
+#include "labeling.h"
+#include "tap_benchmark.h"
+#include "tap_component_type.h"
+#include "tap_logic.h"
+#include "tap_network.h"
+#include "tap_patch_bay.h"
+
+//feedback loops never settle, so cap how many events a case may spend on them
+static constexpr int FEEDBACK_EVENT_CAP = 2000000;
+static constexpr int FEEDBACK_BLOCK_EVENT_CAP = 8192;
+static constexpr int BENCH_BLOCK_SIZE = 512;
+
+//microbenchmarks keep the best of this many timed rounds
+static constexpr int MICRO_ROUNDS = 5;
+static constexpr uint32_t MICRO_NOISE_SIZE = 4096;
+static constexpr int MICRO_OSCILLATOR_FRAMES = 64;
+
+void TapBenchmark::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_scale"), &TapBenchmark::get_scale);
+	ClassDB::bind_method(D_METHOD("set_scale", "scale"), &TapBenchmark::set_scale);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "scale", PROPERTY_HINT_RANGE, "1,4096,1,or_greater"), "set_scale", "get_scale");
+
+	ClassDB::bind_method(D_METHOD("get_simulated_seconds"), &TapBenchmark::get_simulated_seconds);
+	ClassDB::bind_method(D_METHOD("set_simulated_seconds", "seconds"), &TapBenchmark::set_simulated_seconds);
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "simulated_seconds"), "set_simulated_seconds", "get_simulated_seconds");
+
+	ClassDB::bind_method(D_METHOD("get_mix_rate"), &TapBenchmark::get_mix_rate);
+	ClassDB::bind_method(D_METHOD("set_mix_rate", "mix_rate"), &TapBenchmark::set_mix_rate);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "mix_rate"), "set_mix_rate", "get_mix_rate");
+
+	ClassDB::bind_method(D_METHOD("get_tick_rate"), &TapBenchmark::get_tick_rate);
+	ClassDB::bind_method(D_METHOD("set_tick_rate", "tick_rate"), &TapBenchmark::set_tick_rate);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "tick_rate"), "set_tick_rate", "get_tick_rate");
+
+	ClassDB::bind_method(D_METHOD("get_sample_skip"), &TapBenchmark::get_sample_skip);
+	ClassDB::bind_method(D_METHOD("set_sample_skip", "sample_skip"), &TapBenchmark::set_sample_skip);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "sample_skip"), "set_sample_skip", "get_sample_skip");
+
+	ClassDB::bind_method(D_METHOD("get_micro_iterations"), &TapBenchmark::get_micro_iterations);
+	ClassDB::bind_method(D_METHOD("set_micro_iterations", "iterations"), &TapBenchmark::set_micro_iterations);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "micro_iterations"), "set_micro_iterations", "get_micro_iterations");
+
+	ClassDB::bind_method(D_METHOD("get_micro_warmup"), &TapBenchmark::get_micro_warmup);
+	ClassDB::bind_method(D_METHOD("set_micro_warmup", "warmup"), &TapBenchmark::set_micro_warmup);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "micro_warmup"), "set_micro_warmup", "get_micro_warmup");
+
+	ClassDB::bind_method(D_METHOD("run_process_to_case", "name"), &TapBenchmark::run_process_to_case);
+	ClassDB::bind_method(D_METHOD("run_mix_case", "name"), &TapBenchmark::run_mix_case);
+	ClassDB::bind_method(D_METHOD("run_suite", "json_path"), &TapBenchmark::run_suite, DEFVAL(String()));
+
+	ClassDB::bind_static_method("TapBenchmark", D_METHOD("get_case_names"), &TapBenchmark::get_case_names);
+
+	ClassDB::bind_method(D_METHOD("run_microbenchmarks"), &TapBenchmark::run_microbenchmarks);
+	ClassDB::bind_method(D_METHOD("save_micro_baseline", "path"), &TapBenchmark::save_micro_baseline);
+	ClassDB::bind_method(D_METHOD("micro_report", "baseline_path"), &TapBenchmark::micro_report, DEFVAL(String()));
+}
+
+int TapBenchmark::get_scale() const {
+	return scale;
+}
+
+void TapBenchmark::set_scale(int new_scale) {
+	scale = MAX(new_scale, 1);
+}
+
+double TapBenchmark::get_simulated_seconds() const {
+	return simulated_seconds;
+}
+
+void TapBenchmark::set_simulated_seconds(double seconds) {
+	simulated_seconds = MAX(seconds, 0.0);
+}
+
+int TapBenchmark::get_mix_rate() const {
+	return mix_rate;
+}
+
+void TapBenchmark::set_mix_rate(int new_mix_rate) {
+	mix_rate = MAX(new_mix_rate, 1);
+}
+
+int TapBenchmark::get_tick_rate() const {
+	return tick_rate;
+}
+
+void TapBenchmark::set_tick_rate(int new_tick_rate) {
+	tick_rate = MAX(new_tick_rate, 1);
+}
+
+int TapBenchmark::get_sample_skip() const {
+	return sample_skip;
+}
+
+void TapBenchmark::set_sample_skip(int new_sample_skip) {
+	sample_skip = MAX(new_sample_skip, 1);
+}
+
+int TapBenchmark::get_micro_iterations() const {
+	return micro_iterations;
+}
+
+void TapBenchmark::set_micro_iterations(int iterations) {
+	micro_iterations = MAX(iterations, 1);
+}
+
+int TapBenchmark::get_micro_warmup() const {
+	return micro_warmup;
+}
+
+void TapBenchmark::set_micro_warmup(int warmup) {
+	micro_warmup = MAX(warmup, 0);
+}
+
+PackedStringArray TapBenchmark::get_case_names() {
+	PackedStringArray names;
+	names.push_back("mixer_chain");
+	names.push_back("gate_tree");
+	names.push_back("logic_tree");
+	names.push_back("fanout_net");
+	names.push_back("feedback_loop");
+	return names;
+}
+
+/*
+Circuit generators.
+*/
+
+static Ref<TapComponentType> make_component_type(const StringName &name, const StringName &solver, int pin_count, const Vector<int> &sensitive) {
+	Ref<TapComponentType> component_type;
+	component_type.instantiate();
+	component_type->set_type_name(name);
+	component_type->set_solver_function(solver);
+	component_type->set_pin_count(pin_count);
+	component_type->set_sensitive_pins(sensitive);
+	return component_type;
+}
+
+static TapBenchmark::bench_circuit_t make_bench_circuit(const TypedArray<TapComponentType> &component_types) {
+	TapBenchmark::bench_circuit_t bench;
+	bench.circuit.instantiate();
+	bench.circuit->instantiate();
+	bench.circuit->get_network()->set_component_types(component_types);
+	return bench;
+}
+
+static PackedInt64Array pin_array(std::initializer_list<tap_label_t> pins) {
+	PackedInt64Array arr;
+	for (tap_label_t pid : pins) {
+		arr.push_back(pid);
+	}
+	return arr;
+}
+
+TapBenchmark::bench_circuit_t TapBenchmark::build_mixer_chain(int length) {
+	TypedArray<TapComponentType> component_types;
+	component_types.push_back(make_component_type("mixer", "mixer", 4, { 0, 1 }));
+	bench_circuit_t bench = make_bench_circuit(component_types);
+
+	Ref<TapNetwork> network = bench.circuit->get_network();
+	Ref<TapPatchBay> patch_bay = bench.circuit->get_patch_bay();
+
+	tap_label_t a = patch_bay->add_pin(Vector2());
+	tap_label_t b = patch_bay->add_pin(Vector2());
+	bench.inputs.push_back(a);
+	bench.inputs.push_back(b);
+
+	//each mixer's sum ripples into the next one's first input
+	tap_label_t previous = a;
+	for (int i = 0; i < length; i++) {
+		tap_label_t out = patch_bay->add_pin(Vector2());
+		tap_label_t carry = patch_bay->add_pin(Vector2());
+		network->add_component(pin_array({ previous, b, out, carry }), 0);
+		previous = out;
+	}
+
+	bench.outputs.push_back(previous);
+	return bench;
+}
+
+TapBenchmark::bench_circuit_t TapBenchmark::build_gate_tree(int leaves) {
+	TypedArray<TapComponentType> component_types;
+	component_types.push_back(make_component_type("gate", "gate", 3, { 0, 1 }));
+	bench_circuit_t bench = make_bench_circuit(component_types);
+
+	Ref<TapNetwork> network = bench.circuit->get_network();
+	Ref<TapPatchBay> patch_bay = bench.circuit->get_patch_bay();
+
+	tap_label_t a = patch_bay->add_pin(Vector2());
+	tap_label_t b = patch_bay->add_pin(Vector2());
+	bench.inputs.push_back(a);
+	bench.inputs.push_back(b);
+
+	//every leaf gate listens to both inputs, then the tree halves per level
+	LocalVector<tap_label_t> level;
+	for (int i = 0; i < leaves; i++) {
+		tap_label_t out = patch_bay->add_pin(Vector2());
+		network->add_component(pin_array({ a, b, out }), 0);
+		level.push_back(out);
+	}
+
+	while (level.size() > 1) {
+		LocalVector<tap_label_t> next_level;
+		for (uint32_t i = 0; i + 1 < level.size(); i += 2) {
+			tap_label_t out = patch_bay->add_pin(Vector2());
+			network->add_component(pin_array({ level[i], level[i + 1], out }), 0);
+			next_level.push_back(out);
+		}
+		if (level.size() % 2 == 1) {
+			next_level.push_back(level[level.size() - 1]);
+		}
+		level = next_level;
+	}
+
+	bench.outputs.push_back(level[0]);
+	return bench;
+}
+
+static void push_gate(PackedInt32Array &gates, int op, int a, int b) {
+	gates.push_back(op);
+	gates.push_back(a);
+	gates.push_back(b);
+	gates.push_back(0);
+}
+
+TapBenchmark::bench_circuit_t TapBenchmark::build_logic_tree(int leaves) {
+	//gate_tree's AND tree compiled into one logic block, behind converters
+	int gate_limit = (tap_logic_t::MAX_NETS - 2) / 2;
+	leaves = CLAMP(leaves, 1, gate_limit);
+
+	PackedInt32Array gates;
+	LocalVector<int> level;
+	int next_net = 2;
+	for (int i = 0; i < leaves; i++) {
+		push_gate(gates, TapComponentType::LOGIC_AND, 0, 1);
+		level.push_back(next_net++);
+	}
+	while (level.size() > 1) {
+		LocalVector<int> next_level;
+		for (uint32_t i = 0; i + 1 < level.size(); i += 2) {
+			push_gate(gates, TapComponentType::LOGIC_AND, level[i], level[i + 1]);
+			next_level.push_back(next_net++);
+		}
+		if (level.size() % 2 == 1) {
+			next_level.push_back(level[level.size() - 1]);
+		}
+		level = next_level;
+	}
+	PackedInt32Array outputs;
+	outputs.push_back(level[0]);
+
+	Ref<TapComponentType> logic_type = make_component_type("logic_tree", "logic", 3, { 0, 1 });
+	logic_type->compile_logic(2, gates, outputs);
+
+	TypedArray<TapComponentType> component_types;
+	component_types.push_back(make_component_type("analog_to_logic", "analog_to_logic", 2, { 0 }));
+	component_types.push_back(logic_type);
+	component_types.push_back(make_component_type("logic_to_analog", "logic_to_analog", 2, { 0 }));
+	bench_circuit_t bench = make_bench_circuit(component_types);
+
+	Ref<TapNetwork> network = bench.circuit->get_network();
+	Ref<TapPatchBay> patch_bay = bench.circuit->get_patch_bay();
+
+	tap_label_t a = patch_bay->add_pin(Vector2());
+	tap_label_t b = patch_bay->add_pin(Vector2());
+	tap_label_t logic_a = patch_bay->add_pin(Vector2());
+	tap_label_t logic_b = patch_bay->add_pin(Vector2());
+	tap_label_t logic_out = patch_bay->add_pin(Vector2());
+	tap_label_t out = patch_bay->add_pin(Vector2());
+	bench.inputs.push_back(a);
+	bench.inputs.push_back(b);
+
+	network->add_component(pin_array({ a, logic_a }), 0);
+	network->add_component(pin_array({ b, logic_b }), 0);
+	network->add_component(pin_array({ logic_a, logic_b, logic_out }), 1);
+	network->add_component(pin_array({ logic_out, out }), 2);
+
+	bench.outputs.push_back(out);
+	return bench;
+}
+
+TapBenchmark::bench_circuit_t TapBenchmark::build_fanout_net(int fanout) {
+	bench_circuit_t bench = make_bench_circuit(TypedArray<TapComponentType>());
+
+	Ref<TapNetwork> network = bench.circuit->get_network();
+	Ref<TapPatchBay> patch_bay = bench.circuit->get_patch_bay();
+
+	tap_label_t a = patch_bay->add_pin(Vector2());
+	bench.inputs.push_back(a);
+
+	//one wire from the input to every other pin
+	PackedInt64Array pins;
+	pins.push_back(a);
+	for (int i = 0; i < fanout; i++) {
+		pins.push_back(patch_bay->add_pin(Vector2()));
+	}
+	network->add_component(pins);
+
+	bench.outputs.push_back(pins[pins.size() - 1]);
+	return bench;
+}
+
+TapBenchmark::bench_circuit_t TapBenchmark::build_feedback_loop(int length) {
+	bench_circuit_t bench = make_bench_circuit(TypedArray<TapComponentType>());
+
+	Ref<TapNetwork> network = bench.circuit->get_network();
+	Ref<TapPatchBay> patch_bay = bench.circuit->get_patch_bay();
+
+	tap_label_t a = patch_bay->add_pin(Vector2());
+	bench.inputs.push_back(a);
+
+	LocalVector<tap_label_t> ring;
+	for (int i = 0; i < MAX(length, 2); i++) {
+		ring.push_back(patch_bay->add_pin(Vector2()));
+	}
+
+	//a ring of wires, entered from the input. Anything that gets in circulates
+	//forever.
+	network->add_component(pin_array({ a, ring[0] }));
+	for (uint32_t i = 0; i < ring.size(); i++) {
+		network->add_component(pin_array({ ring[i], ring[(i + 1) % ring.size()] }));
+	}
+
+	bench.outputs.push_back(ring[ring.size() / 2]);
+	return bench;
+}
+
+TapBenchmark::bench_circuit_t TapBenchmark::build_case_internal(const String &name, int size) {
+	if (name == "mixer_chain") {
+		return build_mixer_chain(size);
+	} else if (name == "gate_tree") {
+		return build_gate_tree(size);
+	} else if (name == "logic_tree") {
+		return build_logic_tree(size);
+	} else if (name == "fanout_net") {
+		return build_fanout_net(size);
+	} else if (name == "feedback_loop") {
+		return build_feedback_loop(size);
+	}
+
+	ERR_PRINT("TapBenchmark: unknown case " + name);
+	return bench_circuit_t();
+}
+
+/*
+Runners.
+*/
+
+/*
+Peak memory over one case, above what was in use when it started. The process
+high-water mark only helps when the case sets a new one, so usage is also
+sampled once per block to catch peaks under an older high. Only tracked by
+debug builds, 0 otherwise.
+*/
+struct memory_peak_t {
+	uint64_t start_usage = Memory::get_mem_usage();
+	uint64_t start_max = Memory::get_mem_max_usage();
+	uint64_t sampled = start_usage;
+
+	void sample() {
+		sampled = MAX(sampled, Memory::get_mem_usage());
+	}
+
+	int64_t bytes() {
+		sample();
+		uint64_t max_usage = Memory::get_mem_max_usage();
+		uint64_t peak = max_usage > start_max ? MAX(max_usage, sampled) : sampled;
+		return (int64_t)(peak - start_usage);
+	}
+};
+
+static void fill_metrics(Dictionary &result, const Dictionary &circuit_stats, uint64_t wall_usec, int64_t events, memory_peak_t &memory) {
+	result["events"] = events;
+	result["wall_usec"] = (int64_t)wall_usec;
+	result["events_per_second"] = wall_usec > 0 ? (double)events * 1000000.0 / (double)wall_usec : 0.0;
+	result["ns_per_event"] = events > 0 ? (double)wall_usec * 1000.0 / (double)events : 0.0;
+	result["solver_calls"] = circuit_stats["solver_calls"];
+	result["peak_queue_population"] = circuit_stats["peak_queue_population"];
+	result["peak_memory"] = memory.bytes();
+}
+
+Dictionary TapBenchmark::run_process_to_case(const String &name) {
+	Dictionary result;
+	result["name"] = name;
+	result["path"] = "process_to";
+	result["scale"] = scale;
+
+	memory_peak_t memory;
+	bench_circuit_t bench = build_case_internal(name, scale);
+	ERR_FAIL_COND_V(bench.circuit.is_null(), result);
+
+	Ref<TapCircuit> circuit = bench.circuit;
+	std::lock_guard<std::recursive_mutex> lock(circuit->get_mutex());
+	circuit->reset_stats();
+
+	const bool feedback = name == "feedback_loop";
+	const int64_t total_frames = (int64_t)(simulated_seconds * mix_rate);
+	LocalVector<tap_event_t> run;
+	int64_t events = 0;
+
+	uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+
+	for (int64_t block_start = 0; block_start < total_frames; block_start += BENCH_BLOCK_SIZE) {
+		int64_t block_end = MIN(block_start + BENCH_BLOCK_SIZE, total_frames);
+
+		//a square wave per input, each an octave above the last. Feedback loops
+		//only get one kick.
+		if (!feedback || block_start == 0) {
+			for (uint32_t k = 0; k < bench.inputs.size(); k++) {
+				int64_t half_period = MAX((int64_t)mix_rate / (880 << k), (int64_t)1);
+
+				run.clear();
+				for (int64_t frame = block_start; frame < block_end; frame++) {
+					if (frame % sample_skip != 0) {
+						continue;
+					}
+					float level = (frame / half_period) % 2 == 0 ? 1.0f : -1.0f;
+					run.push_back(tap_event_t{ (tap_time_t)(frame * tick_rate), AudioFrame(level, level), bench.inputs[k], TapPatchBay::COMPONENT_MISSING });
+					if (feedback) {
+						break;
+					}
+				}
+				circuit->push_event_run(bench.inputs[k], run);
+			}
+		}
+
+		int max_events = feedback ? (int)MAX(FEEDBACK_EVENT_CAP - events, (int64_t)0) : -1;
+		int count = 0;
+		circuit->process_to_internal((tap_time_t)(block_end * tick_rate), max_events, 0, count);
+		events += count;
+		memory.sample();
+
+		if (feedback && events >= FEEDBACK_EVENT_CAP) {
+			break;
+		}
+	}
+
+	uint64_t wall_usec = OS::get_singleton()->get_ticks_usec() - start_usec;
+
+	fill_metrics(result, circuit->get_stats(), wall_usec, events, memory);
+	return result;
+}
+
+Dictionary TapBenchmark::run_mix_case(const String &name) {
+	Dictionary result;
+	result["name"] = name;
+	result["path"] = "mix";
+	result["scale"] = scale;
+
+	memory_peak_t memory;
+	bench_circuit_t bench = build_case_internal(name, scale);
+	ERR_FAIL_COND_V(bench.circuit.is_null(), result);
+
+	Ref<AudioStreamTapSimulator> simulator;
+	simulator.instantiate();
+	simulator->set_circuit(bench.circuit);
+	simulator->set_sample_skip(sample_skip);
+	simulator->set_tick_rate(tick_rate);
+
+	TypedDictionary<tap_label_t, Ref<AudioStream>> streams;
+	for (uint32_t k = 0; k < bench.inputs.size(); k++) {
+		Ref<AudioStreamPrimitive> oscillator;
+		oscillator.instantiate();
+		oscillator->set_frequency(440.0f * (1 << k));
+		oscillator->set_sqr(1.0f);
+		oscillator->set_sin(0.0f);
+		streams.set(bench.inputs[k], oscillator);
+	}
+	simulator->set_input_streams(streams);
+
+	PackedInt64Array output_pids;
+	for (tap_label_t pid : bench.outputs) {
+		output_pids.push_back(pid);
+	}
+	simulator->set_output_pids(output_pids);
+
+	if (name == "feedback_loop") {
+		simulator->set_event_budget(FEEDBACK_BLOCK_EVENT_CAP);
+	}
+
+	Ref<AudioStreamTapSimulatorPlayback> playback = simulator->instantiate_playback();
+	ERR_FAIL_COND_V(playback.is_null(), result);
+	//the suite's rate, not whatever the AudioServer happens to run at
+	playback->set_mix_rate_internal(mix_rate);
+	playback->start(0.0);
+
+	bench.circuit->reset_stats();
+
+	AudioFrame buffer[BENCH_BLOCK_SIZE];
+	const int64_t total_frames = (int64_t)(simulated_seconds * mix_rate);
+	uint64_t slowest_block_usec = 0;
+
+	uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+
+	for (int64_t done = 0; done < total_frames; done += BENCH_BLOCK_SIZE) {
+		int frames = (int)MIN((int64_t)BENCH_BLOCK_SIZE, total_frames - done);
+
+		uint64_t block_start_usec = OS::get_singleton()->get_ticks_usec();
+		playback->mix(buffer, 1.0f, frames);
+		slowest_block_usec = MAX(slowest_block_usec, OS::get_singleton()->get_ticks_usec() - block_start_usec);
+		memory.sample();
+	}
+
+	uint64_t wall_usec = OS::get_singleton()->get_ticks_usec() - start_usec;
+	playback->stop();
+
+	Dictionary circuit_stats = bench.circuit->get_stats();
+	fill_metrics(result, circuit_stats, wall_usec, (int64_t)circuit_stats["events_processed"], memory);
+	result["slowest_block_usec"] = (int64_t)slowest_block_usec;
+	result["deadline_misses"] = simulator->get_deadline_miss_count();
+	return result;
+}
+
+Dictionary TapBenchmark::run_suite(const String &json_path) {
+	Dictionary results;
+	results["scale"] = scale;
+	results["simulated_seconds"] = simulated_seconds;
+	results["mix_rate"] = mix_rate;
+	results["tick_rate"] = tick_rate;
+	results["sample_skip"] = sample_skip;
+
+	Array cases;
+	for (const String &name : get_case_names()) {
+		Dictionary process_to_result = run_process_to_case(name);
+		Dictionary mix_result = run_mix_case(name);
+		cases.push_back(process_to_result);
+		cases.push_back(mix_result);
+
+		print_line(vformat("TapBenchmark: %s: process_to %.1f ns/event, mix %.1f ns/event", name, (double)process_to_result["ns_per_event"], (double)mix_result["ns_per_event"]));
+	}
+	results["cases"] = cases;
+
+	if (!json_path.is_empty()) {
+		Ref<FileAccess> file = FileAccess::open(json_path, FileAccess::WRITE);
+		if (file.is_null()) {
+			ERR_PRINT("TapBenchmark: could not write results to " + json_path);
+		} else {
+			file->store_string(JSON::stringify(results, "\t"));
+		}
+	}
+
+	return results;
+}
+
+/*
+Microbenchmarks.
+*/
+
+//results get folded in here so the optimizer can't drop the work being timed
+static volatile float micro_sink = 0.0f;
+
+template <typename F>
+static double time_micro(F &&op, int warmup, int iterations) {
+	for (int i = 0; i < warmup; i++) {
+		op(i);
+	}
+
+	uint64_t best_usec = UINT64_MAX;
+	for (int round = 0; round < MICRO_ROUNDS; round++) {
+		uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < iterations; i++) {
+			op(i);
+		}
+		best_usec = MIN(best_usec, OS::get_singleton()->get_ticks_usec() - start_usec);
+	}
+
+	return (double)best_usec * 1000.0 / (double)iterations;
+}
+
+/*
+Keep a queue at a steady population, popping the earliest event and inserting
+one `delay(i)` ticks after it.
+*/
+template <typename D>
+static double time_queue(int population, D &&delay, int warmup, int iterations) {
+	tap_queue_t queue;
+	for (int i = 0; i < population; i++) {
+		tap_time_t time = delay(i);
+		queue.insert(tap_event_t{ time, AudioFrame(0.0f, 0.0f), (tap_label_t)i, TapPatchBay::COMPONENT_MISSING }, time);
+	}
+
+	return time_micro([&](int i) {
+		tap_event_t event = queue.pop_minimum().first;
+		event.time += delay(i);
+		queue.insert(event, event.time);
+	},
+			warmup, iterations);
+}
+
+Dictionary TapBenchmark::run_microbenchmarks() {
+	Dictionary results;
+
+	//fixed seed so every run sees the same inputs
+	LocalVector<uint32_t> noise;
+	LocalVector<float> noise_f;
+	uint32_t x = 0x9E3779B9;
+	for (uint32_t i = 0; i < MICRO_NOISE_SIZE; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		noise.push_back(x);
+		noise_f.push_back((float)(x & 0xFFFF) / 32767.5f - 1.0f);
+	}
+	auto n = [&](int i) { return noise[(uint32_t)i % MICRO_NOISE_SIZE]; };
+	auto nf = [&](int i) { return noise_f[(uint32_t)i % MICRO_NOISE_SIZE]; };
+
+	//event queue under the time distributions it actually sees: input runs
+	//arriving in order, solvers scheduling a few ticks out, and a wide spread
+	//of far off events
+	results["queue_input_runs"] = time_queue(
+			64, [&](int) { return (tap_time_t)(tick_rate * sample_skip); }, micro_warmup, micro_iterations);
+	results["queue_solver_delays"] = time_queue(
+			256, [&](int i) { return (tap_time_t)(1 + n(i) % 8); }, micro_warmup, micro_iterations);
+	results["queue_spread"] = time_queue(
+			4096, [&](int i) { return (tap_time_t)(n(i) % 1000000); }, micro_warmup, micro_iterations);
+
+	//labeling under churn, with a handful of holes open at any time
+	{
+		const int size = 1024;
+		Labeling<int> labeling;
+		for (int i = 0; i < size; i++) {
+			labeling.label_add(i);
+		}
+
+		results["labeling_churn"] = time_micro([&](int i) {
+			int label = n(i) % size;
+			labeling.label_remove(label);
+			micro_sink = micro_sink + (float)labeling.label_add(i);
+		},
+				micro_warmup, micro_iterations);
+
+		results["labeling_get"] = time_micro([&](int i) {
+			micro_sink = micro_sink + (float)labeling.label_get(n(i) % size).value_or(0);
+		},
+				micro_warmup, micro_iterations);
+	}
+
+	//every registered solver on four synthetic pins
+	for (const KeyValue<StringName, tap_component_type_t::solver_t> &entry : TapComponentType::solver_registry) {
+		tap_component_type_t::solver_t solver = entry.value;
+
+		tap_event_t events[4];
+		Vector<const tap_event_t *> pins;
+		for (int p = 0; p < 4; p++) {
+			events[p] = tap_event_t{ 0, AudioFrame(0.0f, 0.0f), (tap_label_t)p, TapPatchBay::COMPONENT_MISSING };
+			pins.push_back(&events[p]);
+		}
+		//pin 0 looks like the component's own tick, so sources do their full work
+		events[0].source_cid = 0;
+		Ref<TapComponentType> solver_type;
+		solver_type.instantiate();
+		solver_type->set_solver_function(entry.key);
+		tap_component_type_t component_type = solver_type->get_component_type_internal();
+		LocalVector<AudioFrame> memory;
+		memory.resize(component_type.memory_size);
+		for (AudioFrame &slot : memory) {
+			slot = AudioFrame(0.0f, 0.0f);
+		}
+		tap_queue_t queue;
+
+		results["solver_" + String(entry.key)] = time_micro([&](int i) {
+			events[0].time = i;
+			events[0].state = AudioFrame(nf(i), nf(i + 1));
+			events[1].state = AudioFrame(nf(i + 2), nf(i + 3));
+			solver(pins, queue, i, 0, component_type, memory.ptr());
+			while (!queue.is_empty()) {
+				micro_sink = micro_sink + queue.pop_minimum().first.state.left;
+			}
+		},
+				micro_warmup, micro_iterations);
+	}
+
+	//tap_frame conversions
+	results["tap_frame_from_audio"] = time_micro([&](int i) {
+		tap_frame frame(AudioFrame(nf(i), nf(i + 1)));
+		micro_sink = micro_sink + (float)frame.left;
+	},
+			micro_warmup, micro_iterations);
+
+	results["tap_frame_to_audio"] = time_micro([&](int i) {
+		tap_frame frame((tap_frame::bytes_t)n(i), (tap_frame::bytes_t)n(i + 1));
+		micro_sink = micro_sink + frame.audio_frame().left;
+	},
+			micro_warmup, micro_iterations);
+
+	results["tap_frame_delta"] = time_micro([&](int i) {
+		tap_frame a((tap_frame::bytes_t)n(i), (tap_frame::bytes_t)n(i + 1));
+		tap_frame b((tap_frame::bytes_t)n(i + 2), (tap_frame::bytes_t)n(i + 3));
+		micro_sink = micro_sink + (float)a.delta(b);
+	},
+			micro_warmup, micro_iterations);
+
+	//oscillator paths, one small block per op with every waveform mixed in
+	for (bool fast : { false, true }) {
+		Ref<AudioStreamPrimitive> oscillator;
+		oscillator.instantiate();
+		oscillator->set_sin(1.0f);
+		oscillator->set_tri(1.0f);
+		oscillator->set_sqr(1.0f);
+		oscillator->set_saw(1.0f);
+		oscillator->set_fast_oscillator(fast);
+
+		Ref<AudioStreamPlayback> playback = oscillator->instantiate_playback();
+		playback->start(0.0);
+
+		AudioFrame buffer[MICRO_OSCILLATOR_FRAMES];
+		results[fast ? "primitive_mix_fast" : "primitive_mix_reference"] = time_micro([&](int) {
+			playback->mix(buffer, 1.0f, MICRO_OSCILLATOR_FRAMES);
+			micro_sink = micro_sink + buffer[MICRO_OSCILLATOR_FRAMES - 1].left;
+		},
+				micro_warmup, micro_iterations);
+	}
+
+	return results;
+}
+
+Error TapBenchmark::save_micro_baseline(const String &path) {
+	Dictionary results = run_microbenchmarks();
+
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(file.is_null(), err, "TapBenchmark: could not write baseline to " + path);
+
+	file->store_string(JSON::stringify(results, "\t"));
+	return OK;
+}
+
+String TapBenchmark::micro_report(const String &baseline_path) {
+	Dictionary baseline;
+	if (!baseline_path.is_empty()) {
+		Variant parsed = JSON::parse_string(FileAccess::get_file_as_string(baseline_path));
+		if (parsed.get_type() == Variant::DICTIONARY) {
+			baseline = parsed;
+		} else {
+			ERR_PRINT("TapBenchmark: could not read baseline " + baseline_path);
+		}
+	}
+
+	Dictionary results = run_microbenchmarks();
+
+	String report = vformat("TapBenchmark microbenchmarks: %d iterations, %d warmup, best of %d\n", micro_iterations, micro_warmup, MICRO_ROUNDS);
+	report += String("case").rpad(28) + String("ns/op").lpad(12) + String("baseline").lpad(12) + String("change").lpad(10) + "\n";
+
+	Array names = results.keys();
+	for (int i = 0; i < names.size(); i++) {
+		double ns = results[names[i]];
+		String line = String(names[i]).rpad(28) + String::num(ns, 2).lpad(12);
+
+		if (baseline.has(names[i])) {
+			double base_ns = baseline[names[i]];
+			String change = base_ns > 0.0 ? vformat("%+.1f%%", (ns - base_ns) * 100.0 / base_ns) : String("-");
+			line += String::num(base_ns, 2).lpad(12) + change.lpad(10);
+		} else {
+			line += String("-").lpad(12) + String("-").lpad(10);
+		}
+
+		report += line + "\n";
+	}
+
+	print_line(report);
+	return report;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "core/object/ref_counted.h"
+#include "core/templates/local_vector.h"
+#include "core/variant/dictionary.h"
+
+#include "tap_circuit.h"
+#include "tap_circuit_types.h"
+
+/**
+ * @brief Headless benchmarks over generated circuits.
+ *
+ * Builds parametric circuits (ripple chains of mixers, wide gate trees, the
+ * same trees as one bit-parallel logic block, high fanout wire nets, feedback
+ * loops), drives them with square wave inputs and
+ * times both `TapCircuit::process_to` directly and the full
+ * `AudioStreamTapSimulatorPlayback::mix` path fed by AudioStreamPrimitives.
+ *
+ * Meant to be run from a script under `--headless`, e.g.
+ * `godot --headless --script bench.gd` with
+ * `TapBenchmark.new().run_suite("user://bench.json")` in `_init`. Test builds
+ * also run every case, small, from `tests/test_tap_benchmark.h`.
+ *
+ * Peak memory is the most a case had allocated at once above what was in use
+ * when it started, from `Memory::get_mem_usage` and `get_mem_max_usage`, so
+ * it's only non-zero in debug builds. The mix path runs at `mix_rate` whatever
+ * the AudioServer is set to.
+ *
+ * @param scale Size parameter handed to every generator: chain length, tree
+ * leaf count, fanout, loop length.
+ * @param simulated_seconds Audio time simulated per case.
+ * @param mix_rate Sample rate the inputs are generated at.
+ * @param tick_rate Circuit ticks per sample.
+ * @param sample_skip Samples per input event.
+ *
+ * The microbenchmarks time the pieces under the hot path in isolation: the
+ * event queue, Labeling, every registered solver, tap_frame conversions and
+ * both AudioStreamPrimitive oscillator paths.
+ * Each case runs a fixed number of warmup and timed iterations, and the best of
+ * a few rounds is kept so repeated runs are comparable. Test builds run them
+ * with a few iterations alongside the suite.
+ *
+ * @param micro_iterations Timed iterations per round of each microbenchmark.
+ * @param micro_warmup Untimed iterations before the first round.
+ */
+class TapBenchmark : public RefCounted {
+	GDCLASS(TapBenchmark, RefCounted);
+
+	int scale = 64;
+	double simulated_seconds = 1.0;
+	int mix_rate = 44100;
+	int tick_rate = 1024;
+	int sample_skip = 2;
+
+	int micro_iterations = 100000;
+	int micro_warmup = 10000;
+
+protected:
+	static void _bind_methods();
+
+public:
+	/// @brief A generated circuit and the pins a driver should use
+	struct bench_circuit_t {
+		Ref<TapCircuit> circuit;
+		LocalVector<tap_label_t> inputs;
+		LocalVector<tap_label_t> outputs;
+	};
+
+	static bench_circuit_t build_mixer_chain(int length);
+	static bench_circuit_t build_gate_tree(int leaves);
+	static bench_circuit_t build_logic_tree(int leaves);
+	static bench_circuit_t build_fanout_net(int fanout);
+	static bench_circuit_t build_feedback_loop(int length);
+
+	/**
+	 * @brief Build one of the generated circuits by name: "mixer_chain",
+	 * "gate_tree", "logic_tree", "fanout_net" or "feedback_loop".
+	 */
+	static bench_circuit_t build_case_internal(const String &name, int size);
+
+	int get_scale() const;
+	void set_scale(int scale);
+
+	double get_simulated_seconds() const;
+	void set_simulated_seconds(double seconds);
+
+	int get_mix_rate() const;
+	void set_mix_rate(int mix_rate);
+
+	int get_tick_rate() const;
+	void set_tick_rate(int tick_rate);
+
+	int get_sample_skip() const;
+	void set_sample_skip(int sample_skip);
+
+	int get_micro_iterations() const;
+	void set_micro_iterations(int iterations);
+
+	int get_micro_warmup() const;
+	void set_micro_warmup(int warmup);
+
+	/**
+	 * @brief Time `TapCircuit::process_to` on a generated circuit, pushing a
+	 * square wave into its inputs one block at a time.
+	 */
+	Dictionary run_process_to_case(const String &name);
+
+	/**
+	 * @brief Time the full `AudioStreamTapSimulatorPlayback::mix` path on a
+	 * generated circuit, fed by AudioStreamPrimitive square waves.
+	 */
+	Dictionary run_mix_case(const String &name);
+
+	/**
+	 * @brief Run every case on both paths. If `json_path` is not empty, the
+	 * results are also saved there as JSON so runs can be diffed.
+	 */
+	Dictionary run_suite(const String &json_path = String());
+
+	static PackedStringArray get_case_names();
+
+	/**
+	 * @brief Run every microbenchmark, returning nanoseconds per operation keyed
+	 * by case name.
+	 */
+	Dictionary run_microbenchmarks();
+
+	/**
+	 * @brief Run the microbenchmarks and save them to `path` as the baseline
+	 * later reports compare against.
+	 */
+	Error save_micro_baseline(const String &path);
+
+	/**
+	 * @brief Run the microbenchmarks and format a plain-text table of the
+	 * results. If `baseline_path` names a file saved by `save_micro_baseline`,
+	 * each case is listed next to its baseline with the relative change.
+	 */
+	String micro_report(const String &baseline_path = String());
+
+	TapBenchmark() = default;
+};
@@ -1,12 +1,16 @@
 #include <mutex>
 #include <optional>
 
+#include "core/io/file_access.h"
 #include "core/object/class_db.h"
 
 #include "core/object/object.h"
+#include "core/os/os.h"
+#include "servers/audio_server.h"
 #include "tap_circuit_types.h"
 #include "tap_component_type.h"
 #include "tap_circuit.h"
+#include "tap_monitors.h"
 
 void TapCircuit::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_network"), &TapCircuit::get_network);
@@ -20,14 +24,39 @@ void TapCircuit::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("get_latest_event_time"), &TapCircuit::get_latest_event_time);
 	ClassDB::bind_method(D_METHOD("get_event_count"), &TapCircuit::get_event_count);
+	ClassDB::bind_method(D_METHOD("get_stats"), &TapCircuit::get_stats);
+	ClassDB::bind_method(D_METHOD("reset_stats"), &TapCircuit::reset_stats);
+
+	ClassDB::bind_method(D_METHOD("is_profiling"), &TapCircuit::is_profiling);
+	ClassDB::bind_method(D_METHOD("set_profiling", "enabled"), &TapCircuit::set_profiling);
+	ClassDB::bind_method(D_METHOD("get_profile_sample_interval"), &TapCircuit::get_profile_sample_interval);
+	ClassDB::bind_method(D_METHOD("set_profile_sample_interval", "interval"), &TapCircuit::set_profile_sample_interval);
+	ClassDB::bind_method(D_METHOD("reset_profile"), &TapCircuit::reset_profile);
+	ClassDB::bind_method(D_METHOD("get_profile"), &TapCircuit::get_profile);
+	ClassDB::bind_method(D_METHOD("export_profile_trace", "path"), &TapCircuit::export_profile_trace);
+
+	ClassDB::bind_method(D_METHOD("is_tracing"), &TapCircuit::is_tracing);
+	ClassDB::bind_method(D_METHOD("set_tracing", "enabled"), &TapCircuit::set_tracing);
+	ClassDB::bind_method(D_METHOD("get_trace_capacity"), &TapCircuit::get_trace_capacity);
+	ClassDB::bind_method(D_METHOD("set_trace_capacity", "bytes"), &TapCircuit::set_trace_capacity);
+	ClassDB::bind_method(D_METHOD("clear_trace"), &TapCircuit::clear_trace);
+	ClassDB::bind_method(D_METHOD("get_trace_record_count"), &TapCircuit::get_trace_record_count);
+	ClassDB::bind_method(D_METHOD("save_trace", "path"), &TapCircuit::save_trace);
+	ClassDB::bind_method(D_METHOD("export_trace_vcd", "path", "ticks_per_second"), &TapCircuit::export_trace_vcd, DEFVAL(0.0));
 
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "network", PROPERTY_HINT_RESOURCE_TYPE, "TapNetwork"), "set_network", "get_network");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "patch_bay", PROPERTY_HINT_RESOURCE_TYPE, "TapPatchBay"), "set_patch_bay", "get_patch_bay");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "tick_rate", PROPERTY_HINT_RANGE, "0,1024"), "set_tick_rate", "get_tick_rate");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "latest_event_time"), "", "get_latest_event_time");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "profiling", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_profiling", "is_profiling");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "profile_sample_interval", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_profile_sample_interval", "get_profile_sample_interval");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "tracing", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_tracing", "is_tracing");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "trace_capacity", PROPERTY_HINT_RANGE, "4096,268435456,4096,suffix:B"), "set_trace_capacity", "get_trace_capacity");
 
 	ClassDB::bind_method(D_METHOD("process_once"), &TapCircuit::process_once);
 	ClassDB::bind_method(D_METHOD("process_to"), &TapCircuit::process_to);
+	ClassDB::bind_method(D_METHOD("process_to_budgeted", "end_time", "max_events", "max_usec"), &TapCircuit::process_to_budgeted);
+	ClassDB::bind_method(D_METHOD("start_sources", "time"), &TapCircuit::start_sources, DEFVAL(0));
 	ClassDB::bind_method(D_METHOD("clear"), &TapCircuit::clear);
 	ClassDB::bind_method(D_METHOD("instantiate"), &TapCircuit::instantiate);
 }
@@ -69,7 +98,231 @@ tap_time_t TapCircuit::get_latest_event_time() const {
 
 size_t TapCircuit::get_event_count() const {
 	std::lock_guard<std::recursive_mutex> lock(mutex);
-	return patch_bay->get_queue_internal().get_population();
+	return patch_bay->get_event_count();
+}
+
+Dictionary TapCircuit::get_stats() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	Dictionary dict;
+	dict["events_processed"] = (int64_t)stats.events;
+	dict["solver_calls"] = (int64_t)stats.get_solver_call_total();
+	dict["peak_queue_population"] = (int64_t)stats.queue_peak;
+	return dict;
+}
+
+void TapCircuit::reset_stats() {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	stats = TapMonitors::counters_t();
+	published_stats = TapMonitors::counters_t();
+}
+
+bool TapCircuit::is_profiling() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return profiling;
+}
+
+void TapCircuit::set_profiling(bool enabled) {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (enabled && !profiling) {
+		profiler.reset();
+	}
+	profiling = enabled;
+}
+
+int TapCircuit::get_profile_sample_interval() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return profiler.sample_interval;
+}
+
+void TapCircuit::set_profile_sample_interval(int interval) {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	profiler.sample_interval = MAX(interval, 1);
+}
+
+void TapCircuit::reset_profile() {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	profiler.reset();
+}
+
+int TapCircuit::get_component_fanout_internal(tap_label_t cid) const {
+	std::optional<tap_component_t> component = network->get_component_internal(cid);
+	if (!component.has_value()) {
+		return 0;
+	}
+
+	//every other component listening on a pin this one drives. Sensitive pins
+	//are its inputs, so they're skipped. A type with no sensitive list listens
+	//on everything and doesn't say which pins it drives, so all of them count.
+	const Vector<int> &sensitive = component->component_type.sensitive;
+	int fanout = 0;
+	for (int i = 0; i < component->pins.size(); i++) {
+		if (sensitive.has(i)) {
+			continue;
+		}
+		std::optional<tap_pin_t> pin = patch_bay->get_pin_internal(component->pins[i]);
+		if (!pin.has_value()) {
+			continue;
+		}
+		for (tap_label_t other : pin->components) {
+			if (other != cid) {
+				fanout++;
+			}
+		}
+	}
+	return fanout;
+}
+
+struct profile_entry_t {
+	Variant key;
+	StringName type_name;
+	uint64_t invocations = 0;
+	uint64_t events_emitted = 0;
+	uint64_t solver_nsec = 0;
+	int64_t fanout = 0;
+	int64_t component_count = 0;
+
+	Dictionary to_dictionary() const {
+		Dictionary dict;
+		dict["invocations"] = (int64_t)invocations;
+		dict["events_emitted"] = (int64_t)events_emitted;
+		dict["solver_usec"] = (double)solver_nsec / 1000.0;
+		dict["fanout"] = fanout;
+		return dict;
+	}
+};
+
+struct profile_entry_costlier_t {
+	bool operator()(const profile_entry_t &a, const profile_entry_t &b) const {
+		return a.solver_nsec > b.solver_nsec;
+	}
+};
+
+Dictionary TapCircuit::get_profile() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	LocalVector<profile_entry_t> component_entries;
+	LocalVector<profile_entry_t> type_entries;
+	HashMap<StringName, uint32_t> type_indices;
+
+	for (const KeyValue<tap_label_t, tap_profiler_t::component_profile_t> &kv : profiler.components) {
+		const tap_profiler_t::component_profile_t &profile = kv.value;
+
+		profile_entry_t entry;
+		entry.key = kv.key;
+		entry.type_name = profile.type_name;
+		entry.invocations = profile.invocations;
+		entry.events_emitted = profile.events_emitted;
+		entry.solver_nsec = profile.solver_nsec;
+		entry.fanout = get_component_fanout_internal(kv.key);
+		component_entries.push_back(entry);
+
+		if (!type_indices.has(profile.type_name)) {
+			type_indices.insert(profile.type_name, type_entries.size());
+			profile_entry_t type_entry;
+			type_entry.key = profile.type_name;
+			type_entries.push_back(type_entry);
+		}
+
+		profile_entry_t &type_entry = type_entries[type_indices[profile.type_name]];
+		type_entry.invocations += entry.invocations;
+		type_entry.events_emitted += entry.events_emitted;
+		type_entry.solver_nsec += entry.solver_nsec;
+		type_entry.fanout += entry.fanout;
+		type_entry.component_count++;
+	}
+
+	component_entries.sort_custom<profile_entry_costlier_t>();
+	type_entries.sort_custom<profile_entry_costlier_t>();
+
+	Dictionary component_dict;
+	for (const profile_entry_t &entry : component_entries) {
+		Dictionary dict = entry.to_dictionary();
+		dict["type"] = entry.type_name;
+		component_dict[entry.key] = dict;
+	}
+
+	Dictionary type_dict;
+	for (const profile_entry_t &entry : type_entries) {
+		Dictionary dict = entry.to_dictionary();
+		dict["components"] = entry.component_count;
+		type_dict[entry.key] = dict;
+	}
+
+	PackedInt64Array queue_depth;
+	for (const tap_profiler_t::queue_sample_t &sample : profiler.queue_samples) {
+		queue_depth.push_back(sample.time);
+		queue_depth.push_back(sample.depth);
+	}
+
+	Dictionary dict;
+	dict["components"] = component_dict;
+	dict["types"] = type_dict;
+	dict["queue_depth"] = queue_depth;
+	return dict;
+}
+
+Error TapCircuit::export_profile_trace(const String &path) const {
+	String trace;
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		trace = profiler.to_chrome_trace();
+	}
+
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(file.is_null(), err, "TapCircuit::export_profile_trace: could not open " + path);
+
+	file->store_string(trace);
+	return OK;
+}
+
+bool TapCircuit::is_tracing() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return tracing;
+}
+
+void TapCircuit::set_tracing(bool enabled) {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (enabled && !tracer.is_allocated()) {
+		tracer.allocate(trace_capacity);
+	}
+	tracing = enabled;
+}
+
+int TapCircuit::get_trace_capacity() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return trace_capacity;
+}
+
+void TapCircuit::set_trace_capacity(int bytes) {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	trace_capacity = MAX(bytes, (int)tap_tracer_t::CHUNK_SIZE);
+	if (tracer.is_allocated()) {
+		tracer.allocate(trace_capacity);
+	}
+}
+
+void TapCircuit::clear_trace() {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	tracer.clear();
+}
+
+int64_t TapCircuit::get_trace_record_count() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return tracer.get_record_count();
+}
+
+Error TapCircuit::save_trace(const String &path) const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return tracer.save(path);
+}
+
+Error TapCircuit::export_trace_vcd(const String &path, double ticks_per_second) const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	if (ticks_per_second <= 0.0 && AudioServer::get_singleton()) {
+		ticks_per_second = (double)tick_rate * AudioServer::get_singleton()->get_mix_rate();
+	}
+	return tracer.export_vcd(path, ticks_per_second);
 }
 
 void TapCircuit::process_once_internal(tap_queue_t &queue) {
@@ -78,8 +331,11 @@ void TapCircuit::process_once_internal(tap_queue_t &queue) {
 		return;
 	}
 
-	tap_event_t event = queue.pop_minimum().first;
+	process_event_internal(queue.pop_minimum().first, queue);
+	TapMonitors::flush_internal(stats, published_stats);
+}
 
+void TapCircuit::process_event_internal(const tap_event_t &event, tap_queue_t &queue) {
 	//get the pin
 	std::optional<tap_pin_t> pin = patch_bay->get_pin_internal(event.pid);
 	tap_event_t *state = patch_bay->get_state_internal(event.pid);
@@ -98,11 +354,18 @@ void TapCircuit::process_once_internal(tap_queue_t &queue) {
 	//apply the new state
 	//note mutation happens here in the event handler, not in solvers themselves
 	*state = event;
+	stats.events++;
+
+	if (tracing) {
+		tracer.record(event);
+	}
 
 	//propogate the event to the pin's connections
 	//the "sensitive" mechanic is handled in such a way that these components represent only the sensitive connections
 	for (tap_label_t cid : pin->components) {
-		if (cid == event.source_cid) {
+		//don't bounce an event back into its source, unless that is how the source wakes itself.
+		//checked before the component is copied out, so a skipped bounce costs no copy
+		if (cid == event.source_cid && !network->is_self_scheduling_internal(cid)) {
 			continue;
 		}
 
@@ -125,8 +388,25 @@ void TapCircuit::process_once_internal(tap_queue_t &queue) {
 			input.push_back(component_state);
 		}
 
+		AudioFrame *memory = network->get_memory_internal(component.value());
+
 		//solve the component
-		component->component_type.solver(input, queue, event.time, cid);
+		if (profiling) {
+			uint32_t population_before = queue.get_population();
+			uint64_t start_nsec = tap_profiler_t::now_nsec();
+			component->component_type.solver(input, queue, event.time, cid, component->component_type, memory);
+			uint64_t end_nsec = tap_profiler_t::now_nsec();
+			profiler.record_solve(cid, component->component_type.name, event.time, start_nsec, end_nsec, queue.get_population() - population_before);
+		} else {
+			component->component_type.solver(input, queue, event.time, cid, component->component_type, memory);
+		}
+		stats.count_solver_call(component->component_type.solver_slot);
+	}
+
+	stats.observe_queue(queue.get_population());
+
+	if (profiling) {
+		profiler.sample_queue(event.time, patch_bay->get_event_count());
 	}
 }
 
@@ -136,19 +416,56 @@ void TapCircuit::process_once() {
 		return;
 	}
 
-	tap_queue_t &queue = patch_bay->get_queue_internal();
-	process_once_internal(queue);
+	if (!patch_bay->has_next_event_internal()) {
+		ERR_PRINT(String("Tried to process empty queue"));
+		return;
+	}
+
+	tap_event_t event = patch_bay->pop_next_event_internal();
+	process_event_internal(event, patch_bay->get_queue_internal());
+	TapMonitors::flush_internal(stats, published_stats);
 }
 
 int TapCircuit::process_to(tap_time_t end_time) {
-	tap_queue_t &queue = patch_bay->get_queue_internal();
 	int count = 0;
-	while (!queue.is_empty() && queue.minimum().first.time <= end_time) {
-		process_once_internal(queue);
-		count++;
+	process_to_internal(end_time, -1, 0, count);
+	return count;
+}
+
+tap_time_t TapCircuit::process_to_budgeted(tap_time_t end_time, int max_events, int max_usec) {
+	uint64_t deadline_usec = max_usec > 0 ? OS::get_singleton()->get_ticks_usec() + max_usec : 0;
+	int count = 0;
+	return process_to_internal(end_time, max_events > 0 ? max_events : -1, deadline_usec, count);
+}
+
+tap_time_t TapCircuit::process_to_internal(tap_time_t end_time, int max_events, uint64_t deadline_usec, int &r_count) {
+	//reading the clock costs more than an event, so only check it this often
+	static constexpr int DEADLINE_CHECK_INTERVAL = 16;
+
+	tap_queue_t &queue = patch_bay->get_queue_internal();
+	const int start_count = r_count;
+
+	while (patch_bay->has_next_event_internal()) {
+		tap_time_t next_time = patch_bay->get_next_time_internal();
+		if (next_time > end_time) {
+			break;
+		}
+
+		bool out_of_events = max_events >= 0 && r_count - start_count >= max_events;
+		bool out_of_time = deadline_usec != 0 && r_count % DEADLINE_CHECK_INTERVAL == 0 && r_count > 0 && OS::get_singleton()->get_ticks_usec() >= deadline_usec;
+		if (out_of_events || out_of_time) {
+			TapMonitors::flush_internal(stats, published_stats);
+			//everything before the next pending event is settled
+			return next_time > 0 ? next_time - 1 : 0;
+		}
+
+		tap_event_t event = patch_bay->pop_next_event_internal();
+		process_event_internal(event, queue);
+		r_count++;
 	}
 
-	return count;
+	TapMonitors::flush_internal(stats, published_stats);
+	return end_time;
 }
 
 void TapCircuit::push_event(tap_time_t time, AudioFrame state, tap_label_t pid) {
@@ -156,6 +473,50 @@ void TapCircuit::push_event(tap_time_t time, AudioFrame state, tap_label_t pid)
 	latest_event_time = time > latest_event_time ? time : latest_event_time;
 }
 
+void TapCircuit::push_event_run(tap_label_t pid, LocalVector<tap_event_t> &events) {
+	if (events.is_empty()) {
+		return;
+	}
+
+	for (tap_event_t &event : events) {
+		event.pid = pid;
+		event.source_cid = patch_bay->COMPONENT_MISSING;
+	}
+
+	patch_bay->push_event_run_internal(pid, events.ptr(), events.size());
+
+	tap_time_t last_time = events[events.size() - 1].time;
+	latest_event_time = last_time > latest_event_time ? last_time : latest_event_time;
+}
+
+int TapCircuit::start_sources(tap_time_t time) {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	ERR_FAIL_COND_V_MSG(network.is_null() || patch_bay.is_null(), 0, "TapCircuit::start_sources: circuit is not instantiated.");
+
+	int started = 0;
+	for (tap_label_t cid : network->get_self_scheduling_components_internal()) {
+		std::optional<tap_component_t> component = network->get_component_internal(cid);
+		if (component->pins.is_empty()) {
+			continue;
+		}
+
+		if (!component->component_type.sensitive.has(0)) {
+			WARN_PRINT(vformat("TapCircuit::start_sources: component %d isn't sensitive on pin 0, so it won't wake itself after the first tick.", cid));
+		}
+
+		tap_label_t pid = component->pins[0];
+		const tap_event_t *state = patch_bay->get_state_internal(pid);
+		if (state == nullptr) {
+			continue;
+		}
+
+		patch_bay->get_queue_internal().insert(tap_event_t{ time, state->state, pid, cid }, time);
+		latest_event_time = time > latest_event_time ? time : latest_event_time;
+		started++;
+	}
+	return started;
+}
+
 void TapCircuit::clear() {
 	std::lock_guard<std::recursive_mutex> lock(mutex);
 	patch_bay->clear_pins();
@@ -183,5 +544,23 @@ bool TapCircuit::is_instantiated() const {
 	return instantiated;
 }
 
+Ref<TapCircuit> TapCircuit::clone_internal() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+
+	Ref<TapCircuit> clone;
+	clone.instantiate();
+	clone->instantiate();
+	clone->tick_rate = tick_rate;
+
+	if (patch_bay.is_valid()) {
+		clone->patch_bay->copy_pins_from_internal(*patch_bay.ptr());
+	}
+	if (network.is_valid()) {
+		clone->network->copy_components_from_internal(*network.ptr());
+	}
+
+	return clone;
+}
+
 TapCircuit::TapCircuit() {
 }
\ No newline at end of file
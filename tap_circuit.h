@@ -4,8 +4,11 @@
 
 #include "core/object/ref_counted.h"
 
+#include "tap_monitors.h"
 #include "tap_network.h"
 #include "tap_patch_bay.h"
+#include "tap_profiler.h"
+#include "tap_tracer.h"
 
 /**
  * @brief Aggregate a TapNetwork and TapPatchBay to a full circuit.
@@ -29,6 +32,23 @@ class TapCircuit : public Resource {
 	//network
 	bool instantiated = false;
 
+	/// @brief Running counters, updated while processing events and shared
+	/// with the Performance monitors
+	TapMonitors::counters_t stats;
+	//how much of `stats` the monitors have seen
+	TapMonitors::counters_t published_stats;
+
+	/// @brief Off unless asked for, when it costs one branch per solver call
+	bool profiling = false;
+	tap_profiler_t profiler;
+
+	int get_component_fanout_internal(tap_label_t cid) const;
+
+	/// @brief Records every applied pin change into a bounded ring while on
+	bool tracing = false;
+	int trace_capacity = 1 << 20;
+	tap_tracer_t tracer;
+
 protected:
 	static void _bind_methods();
 
@@ -45,6 +65,69 @@ public:
 	tap_time_t get_latest_event_time() const;
 	size_t get_event_count() const;
 
+	/**
+	 * @brief Events processed, solver calls and the peak queue population since
+	 * the last `reset_stats`.
+	 */
+	Dictionary get_stats() const;
+	void reset_stats();
+
+	bool is_profiling() const;
+	void set_profiling(bool enabled);
+
+	int get_profile_sample_interval() const;
+	void set_profile_sample_interval(int interval);
+
+	void reset_profile();
+
+	/**
+	 * @brief The hot-spot profile recorded while `profiling` was on.
+	 *
+	 * Returns "components", keyed by component label, and "types", keyed by
+	 * type name, both in descending order of solver time. Each entry has the
+	 * solver invocations, events emitted, solver time in microseconds and the
+	 * downstream fan-out. "queue_depth" holds (simulated time, depth) pairs
+	 * sampled every `profile_sample_interval` ticks.
+	 */
+	Dictionary get_profile() const;
+
+	/**
+	 * @brief Save the profile as a Chrome trace JSON file, which can be opened
+	 * in chrome://tracing or Perfetto.
+	 */
+	Error export_profile_trace(const String &path) const;
+
+	bool is_tracing() const;
+	/**
+	 * @brief Start or stop recording pin changes. The ring is allocated the
+	 * first time tracing starts, so recording itself never allocates.
+	 */
+	void set_tracing(bool enabled);
+
+	int get_trace_capacity() const;
+	/**
+	 * @brief Size of the trace ring in bytes. Once it is full the oldest
+	 * changes are dropped. Changing it clears the trace.
+	 */
+	void set_trace_capacity(int bytes);
+
+	void clear_trace();
+	int64_t get_trace_record_count() const;
+
+	/**
+	 * @brief Save the raw delta-encoded trace, see tap_tracer.h for the format.
+	 */
+	Error save_trace(const String &path) const;
+
+	/**
+	 * @brief Save the trace as a VCD file for standard waveform viewers.
+	 *
+	 * Times are in real time at `ticks_per_second`. With 0, that is
+	 * `tick_rate` ticks per sample at the AudioServer mix rate, which is what
+	 * a simulator running at this tick rate and full quality uses.
+	 */
+	Error export_trace_vcd(const String &path, double ticks_per_second = 0.0) const;
+
 	/**
 	 * @brief Clear all elements of the patch bay and network in this simulator.
 	 *
@@ -53,6 +136,15 @@ public:
 	 */
 	void clear();
 
+	/**
+	 * @brief Apply a single event to its pin and run the solvers listening on
+	 * that pin, which push their results into `queue`.
+	 *
+	 * @warning For batch processing only. The circuit must be locked before 
+	 * calling this function.
+	 */
+	void process_event_internal(const tap_event_t &event, tap_queue_t &queue);
+
 	/**
 	 * @brief Process an event with a priority queue as the source.
 	 *
@@ -68,6 +160,8 @@ public:
 	 * @brief Process an event with the TapCircuit's configured patch bay as the source.
 	 *
 	 * Uses the patch bay as the source for a queue, and thus the next event.
+	 * The next event is the earliest of the queue and the patch bay's input
+	 * lanes.
 	 * Since this does not take any internal types as an argument, it can be exposed to the editor.
 	 *
 	 * @warning For batch processing only. The circuit must be locked before 
@@ -88,6 +182,36 @@ public:
 	 */
 	int process_to(tap_time_t end_time);
 
+	/**
+	 * @brief `process_to` with a budget, for callers with a deadline.
+	 *
+	 * Stops early once `max_events` events have been processed or `max_usec`
+	 * microseconds have passed. Whatever is left stays queued and gets picked
+	 * up by the next call.
+	 *
+	 * @warning For batch processing only. The circuit must be locked before 
+	 * calling this function.
+	 *
+	 * @param end_time The target time to simulate to
+	 * @param max_events Event budget, 0 for unlimited
+	 * @param max_usec Wall-clock budget in microseconds, 0 for unlimited
+	 * @return The simulated time reached. Equal to `end_time` if the budget
+	 * held, otherwise the last time at which every event has been processed.
+	 */
+	tap_time_t process_to_budgeted(tap_time_t end_time, int max_events, int max_usec);
+
+	/**
+	 * @brief Internal version of `process_to_budgeted`.
+	 *
+	 * @param max_events Event budget, negative for unlimited
+	 * @param deadline_usec Absolute `OS::get_ticks_usec` deadline, 0 for none
+	 * @param r_count Running event count, incremented per event processed.
+	 * Callers stepping through a block in several calls keep one counter for
+	 * the whole block, so the deadline is checked every few events of the
+	 * block rather than of each call.
+	 */
+	tap_time_t process_to_internal(tap_time_t end_time, int max_events, uint64_t deadline_usec, int &r_count);
+
 	/**
 	 * @brief Push an event and update the internal latest_event_time value.
 	 *
@@ -103,6 +227,32 @@ public:
 	 */
 	void push_event(tap_time_t time, AudioFrame state, tap_label_t pid);
 
+	/**
+	 * @brief Push a time-sorted run of events for one input pid in one call.
+	 *
+	 * The run goes to the pid's input lane on the patch bay instead of the
+	 * heap, and is merged back in when events are popped.
+	 *
+	 * @warning For batch processing only. The circuit must be locked before 
+	 * calling this function.
+	 *
+	 * @param pid The input pin every event in the run targets
+	 * @param events Events sorted by time. Their pid and source are overwritten.
+	 */
+	void push_event_run(tap_label_t pid, LocalVector<tap_event_t> &events);
+
+	/**
+	 * @brief Wake every self-scheduling component, like clocks and oscillators,
+	 * by sending its current pin state back to it at `time`. From there each
+	 * one keeps scheduling its own next transition.
+	 *
+	 * Call once per run on a queue with no pending source events, otherwise
+	 * each source ends up with two interleaved schedules.
+	 *
+	 * @return The number of sources started.
+	 */
+	int start_sources(tap_time_t time);
+
 	/**
 	 * @brief Mutex getter so Audio processes can make their own locks for batch 
 	 * calls. Intended for audio processing.
@@ -120,5 +270,12 @@ public:
 
 	bool is_instantiated() const;
 
+	/**
+	 * @brief Deep copy of the circuit's pins, states and components, with an
+	 * empty event queue. Component types are shared. Profiling and tracing are
+	 * not carried over.
+	 */
+	Ref<TapCircuit> clone_internal() const;
+
 	TapCircuit();
 };
\ No newline at end of file
@@ -77,8 +77,9 @@ struct tap_frame {
 		return AudioFrame(bytes_to_channel(left), bytes_to_channel(left));
 	}
 
-	inline constexpr bytes_t delta(tap_frame with) const {
-		return bytes_diff(left, with.left) + bytes_diff(right, with.right);
+	//widened so a full swing on both channels doesn't wrap around
+	inline constexpr uint32_t delta(tap_frame with) const {
+		return (uint32_t)bytes_diff(left, with.left) + (uint32_t)bytes_diff(right, with.right);
 	}
 };
 
@@ -116,5 +117,5 @@ typedef circuit_queue_t<AudioFrame, tap_time_t, tap_label_t, tap_label_t> tap_qu
 
 //component tap types
 typedef circuit_pin_t<AudioFrame, tap_time_t, tap_label_t> tap_pin_t;
-typedef circuit_component_type_t<tap_time_t, tap_label_t, const tap_event_t *, tap_queue_t> tap_component_type_t;
+typedef circuit_component_type_t<AudioFrame, tap_time_t, tap_label_t, const tap_event_t *, tap_queue_t> tap_component_type_t;
 typedef circuit_component_t<AudioFrame, tap_time_t, tap_label_t, tap_label_t, const tap_event_t *, tap_queue_t> tap_component_t;
\ No newline at end of file
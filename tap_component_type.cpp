@@ -1,10 +1,20 @@
 
+#include <cstring>
+
+#include "core/math/math_funcs.h"
 #include "core/object/class_db.h"
 
 #include "tap_component_type.h"
+#include "tap_dsp.h"
+#include "tap_expression.h"
+#include "tap_logic.h"
+#include "tap_monitors.h"
+#include "tap_patch_bay.h"
 
 // Define the static solver registry
 HashMap<StringName, tap_component_type_t::solver_t> TapComponentType::solver_registry;
+HashSet<StringName> TapComponentType::self_scheduling_registry;
+HashMap<StringName, TapComponentType::memory_size_t> TapComponentType::memory_size_registry;
 
 void TapComponentType::_bind_methods() {
 	// Binding methods for Godot
@@ -20,6 +30,31 @@ void TapComponentType::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_solver_function", "solver_name"), &TapComponentType::set_solver_function);
 	ClassDB::bind_method(D_METHOD("get_solver_function_name"), &TapComponentType::get_solver_function_name);
 
+	ClassDB::bind_method(D_METHOD("set_parameters", "new_parameters"), &TapComponentType::set_parameters);
+	ClassDB::bind_method(D_METHOD("get_parameters"), &TapComponentType::get_parameters);
+
+	ClassDB::bind_method(D_METHOD("set_expression", "new_expression"), &TapComponentType::set_expression);
+	ClassDB::bind_method(D_METHOD("get_expression"), &TapComponentType::get_expression);
+
+	ClassDB::bind_method(D_METHOD("compile_logic", "inputs", "gates", "outputs", "four_state"), &TapComponentType::compile_logic, DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("evaluate_logic", "input_words", "unknown_words"), &TapComponentType::evaluate_logic, DEFVAL(PackedInt64Array()));
+
+	BIND_ENUM_CONSTANT(LOGIC_BUF);
+	BIND_ENUM_CONSTANT(LOGIC_NOT);
+	BIND_ENUM_CONSTANT(LOGIC_AND);
+	BIND_ENUM_CONSTANT(LOGIC_OR);
+	BIND_ENUM_CONSTANT(LOGIC_XOR);
+	BIND_ENUM_CONSTANT(LOGIC_NAND);
+	BIND_ENUM_CONSTANT(LOGIC_NOR);
+	BIND_ENUM_CONSTANT(LOGIC_XNOR);
+	BIND_ENUM_CONSTANT(LOGIC_MUX);
+
+	ClassDB::bind_method(D_METHOD("is_self_scheduling"), &TapComponentType::is_self_scheduling);
+	ClassDB::bind_method(D_METHOD("get_memory_size"), &TapComponentType::get_memory_size);
+
+	ClassDB::bind_method(D_METHOD("bake_lut_from_type", "source", "inputs", "bits"), &TapComponentType::bake_lut_from_type, DEFVAL(8));
+	ClassDB::bind_method(D_METHOD("bake_lut_from_callable", "function", "inputs", "outputs", "bits"), &TapComponentType::bake_lut_from_callable, DEFVAL(8));
+
 	//build the possible values for solver_function enum hint
 	String hint;
 	bool first = true;
@@ -36,6 +71,11 @@ void TapComponentType::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "sensitive_pins"), "set_sensitive_pins", "get_sensitive_pins");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "pin_count"), "set_pin_count", "get_pin_count");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "solver_function", PROPERTY_HINT_ENUM, hint), "set_solver_function", "get_solver_function_name");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_FLOAT32_ARRAY, "parameters"), "set_parameters", "get_parameters");
+	//after parameters, so loading recompiles over the stored program
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "expression", PROPERTY_HINT_MULTILINE_TEXT), "set_expression", "get_expression");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "self_scheduling", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR), "", "is_self_scheduling");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "memory_size", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR), "", "get_memory_size");
 }
 
 void TapComponentType::set_type_name(StringName new_name) {
@@ -67,13 +107,114 @@ void TapComponentType::set_solver_function(StringName solver_name) {
 		ERR_FAIL_MSG("Solver function not found in registry: " + String(solver_name));
 	}
 	solver_function_name = solver_name;
+	if (solver_name != StringName("expression")) {
+		expression = String();
+	}
 	component_type.solver = solver_registry.get(solver_name);
+	component_type.self_scheduling = self_scheduling_registry.has(solver_name);
+	if (component_type.self_scheduling) {
+		//sources wake on their own events at pin 0, so nothing else should call them
+		component_type.sensitive = { 0 };
+	}
+	component_type.solver_slot = TapMonitors::get_solver_slot(component_type.solver);
+	update_memory_size_internal();
 }
 
 StringName TapComponentType::get_solver_function_name() {
 	return solver_function_name;
 }
 
+void TapComponentType::set_parameters(const Vector<float> &new_parameters) {
+	component_type.parameters = new_parameters;
+	update_memory_size_internal();
+}
+
+Vector<float> TapComponentType::get_parameters() const {
+	return component_type.parameters;
+}
+
+bool TapComponentType::is_self_scheduling() const {
+	return component_type.self_scheduling;
+}
+
+int TapComponentType::get_memory_size() const {
+	return component_type.memory_size;
+}
+
+void TapComponentType::set_expression(const String &new_expression) {
+	if (new_expression.is_empty()) {
+		expression = String();
+		return;
+	}
+
+	Vector<float> program;
+	String error;
+	if (tap_expression_t::compile(new_expression, program, error) != OK) {
+		ERR_FAIL_MSG("TapComponentType: could not compile expression, " + error);
+	}
+
+	install_internal("expression", tap_expression_t::get_input_count(program.ptr()), tap_expression_t::get_output_count(program.ptr()), program);
+	expression = new_expression;
+}
+
+String TapComponentType::get_expression() const {
+	return expression;
+}
+
+static_assert((int)TapComponentType::LOGIC_MUX == (int)tap_logic_t::OP_MUX, "LogicOp must match tap_logic_t::opcode_t");
+
+Error TapComponentType::compile_logic(int inputs, const PackedInt32Array &gates, const PackedInt32Array &outputs, bool four_state) {
+	Vector<float> program;
+	String error;
+	Error err = tap_logic_t::compile(inputs, gates, outputs, four_state, program, error);
+	ERR_FAIL_COND_V_MSG(err != OK, err, "TapComponentType: could not compile logic block, " + error);
+
+	install_internal("logic", inputs, outputs.size(), program);
+	return OK;
+}
+
+PackedInt64Array TapComponentType::evaluate_logic(const PackedInt64Array &input_words, const PackedInt64Array &unknown_words) const {
+	PackedInt64Array result;
+	const float *program = component_type.parameters.ptr();
+	ERR_FAIL_COND_V_MSG(solver_function_name != StringName("logic") || !tap_logic_t::is_valid(program, component_type.parameters.size()), result, "TapComponentType: not a compiled logic block.");
+
+	int inputs = tap_logic_t::get_input_count(program);
+	int outputs = tap_logic_t::get_output_count(program);
+	bool four_state = tap_logic_t::is_four_state(program);
+	ERR_FAIL_COND_V_MSG(input_words.size() != inputs, result, vformat("TapComponentType::evaluate_logic: expected %d input words, got %d.", inputs, input_words.size()));
+	ERR_FAIL_COND_V_MSG(!unknown_words.is_empty() && unknown_words.size() != inputs, result, "TapComponentType::evaluate_logic: unknown_words must be empty or one word per input.");
+
+	LocalVector<uint64_t> value;
+	LocalVector<uint64_t> known;
+	value.resize(tap_logic_t::MAX_NETS);
+	known.resize(tap_logic_t::MAX_NETS);
+	for (int i = 0; i < tap_logic_t::MAX_NETS; i++) {
+		value[i] = 0;
+		known[i] = ~(uint64_t)0;
+	}
+	for (int i = 0; i < inputs; i++) {
+		uint64_t unknown = unknown_words.is_empty() ? 0 : (uint64_t)unknown_words[i];
+		known[i] = ~unknown;
+		value[i] = (uint64_t)input_words[i] & known[i];
+	}
+
+	const float *output_nets = four_state ? tap_logic_t::sweep_four_state(program, value.ptr(), known.ptr()) : tap_logic_t::sweep_two_state(program, value.ptr());
+	for (int o = 0; o < outputs; o++) {
+		result.push_back((int64_t)value[(int)output_nets[o] & (tap_logic_t::MAX_NETS - 1)]);
+	}
+	if (four_state) {
+		for (int o = 0; o < outputs; o++) {
+			result.push_back((int64_t)~known[(int)output_nets[o] & (tap_logic_t::MAX_NETS - 1)]);
+		}
+	}
+	return result;
+}
+
+void TapComponentType::update_memory_size_internal() {
+	const memory_size_t *memory_size = memory_size_registry.getptr(solver_function_name);
+	component_type.memory_size = memory_size ? MAX((*memory_size)(component_type), 0) : 0;
+}
+
 void TapComponentType::set_component_type_internal(tap_component_type_t new_component_type) {
 	component_type = new_component_type;
 }
@@ -82,11 +223,149 @@ tap_component_type_t TapComponentType::get_component_type_internal() const {
 	return component_type;
 }
 
+//level at the middle of bucket `index` out of 2^bits, matching lut_index
+static inline float lut_level(int index, int bits) {
+	int shift = 16 - bits;
+	int bytes = ((index << shift) | ((1 << shift) >> 1));
+	return tap_frame::bytes_to_channel((tap_frame::bytes_t)bytes);
+}
+
+//digits of `combination` in base 2^bits, one per input
+static inline void lut_levels(int combination, int inputs, int bits, float *r_levels) {
+	for (int i = 0; i < inputs; i++) {
+		r_levels[i] = lut_level(combination & ((1 << bits) - 1), bits);
+		combination >>= bits;
+	}
+}
+
+Error TapComponentType::prepare_lut_internal(int inputs, int outputs, int bits, int &r_levels) {
+	ERR_FAIL_COND_V_MSG(bits < 1 || bits > MAX_LUT_BITS, ERR_INVALID_PARAMETER, vformat("TapComponentType: lookup table bits must be between 1 and %d.", MAX_LUT_BITS));
+	ERR_FAIL_COND_V_MSG(inputs < 1 || outputs < 1, ERR_INVALID_PARAMETER, "TapComponentType: a lookup table needs at least one input and one output.");
+	ERR_FAIL_COND_V_MSG((int64_t)inputs * bits > 30, ERR_INVALID_PARAMETER, "TapComponentType: too many input levels for a lookup table.");
+
+	r_levels = 1 << (inputs * bits);
+	ERR_FAIL_COND_V_MSG((int64_t)r_levels * outputs > MAX_LUT_ENTRIES, ERR_INVALID_PARAMETER, vformat("TapComponentType: lookup table would need more than %d entries. Lower the resolution.", MAX_LUT_ENTRIES));
+	return OK;
+}
+
+void TapComponentType::install_internal(StringName solver_name, int inputs, int outputs, const Vector<float> &new_parameters) {
+	Vector<int> sensitive;
+	for (int i = 0; i < inputs; i++) {
+		sensitive.push_back(i);
+	}
+
+	set_solver_function(solver_name);
+	component_type.pin_count = inputs + outputs;
+	component_type.sensitive = sensitive;
+	set_parameters(new_parameters);
+}
+
+//lut parameters are bits, input count, output count, then the table
+static Vector<float> lut_parameters(int inputs, int outputs, int bits, const Vector<float> &table) {
+	Vector<float> parameters;
+	parameters.resize(3 + table.size());
+	float *w = parameters.ptrw();
+	w[0] = (float)bits;
+	w[1] = (float)inputs;
+	w[2] = (float)outputs;
+	memcpy(w + 3, table.ptr(), table.size() * sizeof(float));
+	return parameters;
+}
+
+Error TapComponentType::bake_lut_from_type(Ref<TapComponentType> source, int inputs, int bits) {
+	ERR_FAIL_COND_V(source.is_null(), ERR_INVALID_PARAMETER);
+	tap_component_type_t source_type = source->get_component_type_internal();
+	ERR_FAIL_COND_V_MSG(source_type.solver == nullptr, ERR_INVALID_PARAMETER, "TapComponentType: source type has no solver.");
+
+	int outputs = source_type.pin_count - inputs;
+	int levels = 0;
+	Error err = prepare_lut_internal(inputs, outputs, bits, levels);
+	if (err != OK) {
+		return err;
+	}
+
+	int pin_count = inputs + outputs;
+	LocalVector<tap_event_t> events;
+	events.resize(pin_count);
+	Vector<const tap_event_t *> pins;
+	for (int p = 0; p < pin_count; p++) {
+		pins.push_back(&events[p]);
+	}
+
+	LocalVector<AudioFrame> memory;
+	memory.resize(source_type.memory_size);
+	LocalVector<float> input_levels;
+	input_levels.resize(inputs);
+
+	//sample time 0, with every input looking like it just changed
+	Vector<float> table;
+	table.resize(levels * outputs);
+	float *w = table.ptrw();
+	for (int combination = 0; combination < levels; combination++) {
+		lut_levels(combination, inputs, bits, input_levels.ptr());
+		for (int p = 0; p < pin_count; p++) {
+			float level = p < inputs ? input_levels[p] : 0.0f;
+			events[p] = tap_event_t{ 0, AudioFrame(level, level), (tap_label_t)p, TapPatchBay::COMPONENT_MISSING };
+		}
+		for (AudioFrame &slot : memory) {
+			slot = AudioFrame(0.0f, 0.0f);
+		}
+
+		tap_queue_t queue;
+		source_type.solver(pins, queue, 0, 0, source_type, memory.ptr());
+
+		//outputs nobody drove stay at 0. Later events win
+		float *entry = w + (size_t)combination * outputs;
+		for (int o = 0; o < outputs; o++) {
+			entry[o] = 0.0f;
+		}
+		while (!queue.is_empty()) {
+			tap_event_t event = queue.pop_minimum().first;
+			if ((int)event.pid >= inputs && (int)event.pid < pin_count) {
+				entry[event.pid - inputs] = event.state.left;
+			}
+		}
+	}
+
+	install_internal("lut", inputs, outputs, lut_parameters(inputs, outputs, bits, table));
+	return OK;
+}
+
+Error TapComponentType::bake_lut_from_callable(const Callable &function, int inputs, int outputs, int bits) {
+	ERR_FAIL_COND_V(!function.is_valid(), ERR_INVALID_PARAMETER);
+
+	int levels = 0;
+	Error err = prepare_lut_internal(inputs, outputs, bits, levels);
+	if (err != OK) {
+		return err;
+	}
+
+	PackedFloat32Array input_levels;
+	input_levels.resize(inputs);
+
+	Vector<float> table;
+	table.resize(levels * outputs);
+	float *w = table.ptrw();
+	for (int combination = 0; combination < levels; combination++) {
+		lut_levels(combination, inputs, bits, input_levels.ptrw());
+
+		Variant result = function.call(input_levels);
+		ERR_FAIL_COND_V_MSG(result.get_type() != Variant::PACKED_FLOAT32_ARRAY && result.get_type() != Variant::ARRAY, ERR_INVALID_DATA, "TapComponentType::bake_lut_from_callable: function must return an array of output levels.");
+		PackedFloat32Array output_levels = result;
+		ERR_FAIL_COND_V_MSG(output_levels.size() != outputs, ERR_INVALID_DATA, vformat("TapComponentType::bake_lut_from_callable: function returned %d levels, expected %d.", output_levels.size(), outputs));
+
+		memcpy(w + (size_t)combination * outputs, output_levels.ptr(), outputs * sizeof(float));
+	}
+
+	install_internal("lut", inputs, outputs, lut_parameters(inputs, outputs, bits, table));
+	return OK;
+}
+
 /*
 Prebuilt solvers go here.
 */
 
-void wire_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid) {
+void wire_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
 	//find the most recent activation
 	tap_event_t latest;
 	latest.time = (tap_time_t)(-1); //initialize to max value
@@ -121,11 +400,11 @@ void wire_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, ta
 	}
 }
 
-void none_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid) {
+void none_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
 	// ¯\_(ツ)_/¯
 }
 
-void mixer_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid) {
+void mixer_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
 	//add in float space to act more like a mixxer than a binary adder
 	AudioFrame frame0 = pins[0]->state;
 	AudioFrame frame1 = pins[1]->state;
@@ -158,7 +437,7 @@ void mixer_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, t
 	queue.insert({ new_time, carry, pins[3]->pid, cid }, new_time);
 }
 
-void gate_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid) {
+void gate_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
 	//multiply two inputs
 
 	AudioFrame frame0 = pins[0]->state;
@@ -171,15 +450,660 @@ void gate_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, ta
 	queue.insert({ new_time, result, pins[2]->pid, cid }, new_time);
 }
 
+//about 441 Hz at the default 1024 ticks per sample and 44.1kHz
+static constexpr float DEFAULT_SOURCE_PERIOD = 1024.0f * 100.0f;
+//waveform sources send this many events per period unless told otherwise
+static constexpr float DEFAULT_SOURCE_STEPS = 32.0f;
+
+static inline float get_parameter(const tap_component_type_t &type, int index, float fallback) {
+	return index < type.parameters.size() ? type.parameters[index] : fallback;
+}
+
+//a source only acts on the event it sent itself, anything else driving its pin is ignored
+static inline bool is_own_tick(const tap_event_t *pin, tap_time_t current_time, tap_label_t cid) {
+	return pin->time == current_time && pin->source_cid == cid;
+}
+
+static inline tap_time_t get_period(const tap_component_type_t &type) {
+	return (tap_time_t)MAX(get_parameter(type, 0, DEFAULT_SOURCE_PERIOD), 2.0f);
+}
+
+//hold `high` for `high_ticks` of every period and `low` for the rest
+static inline void schedule_toggle(const tap_event_t *pin, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, tap_time_t period, tap_time_t high_ticks, float low, float high) {
+	high_ticks = CLAMP(high_ticks, (tap_time_t)1, period - 1);
+
+	bool is_high = pin->state.left > (low + high) * 0.5f;
+	float next = is_high ? low : high;
+	tap_time_t new_time = current_time + (is_high ? high_ticks : period - high_ticks);
+
+	queue.insert({ new_time, AudioFrame(next, next), pin->pid, cid }, new_time);
+}
+
+//send the waveform's value one step ahead, with phase measured from time 0
+template <typename F>
+static inline void schedule_step(const tap_event_t *pin, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, F &&waveform) {
+	tap_time_t period = get_period(type);
+	float amplitude = get_parameter(type, 1, 1.0f);
+	tap_time_t step = (tap_time_t)MAX(get_parameter(type, 2, (float)period / DEFAULT_SOURCE_STEPS), 1.0f);
+
+	tap_time_t new_time = current_time + step;
+	float phase = (float)(new_time % period) / (float)period;
+	float value = amplitude * waveform(phase);
+
+	queue.insert({ new_time, AudioFrame(value, value), pin->pid, cid }, new_time);
+}
+
+void clock_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: period, duty. Toggles between 0 and 1
+	if (!is_own_tick(pins[0], current_time, cid)) {
+		return;
+	}
+
+	tap_time_t period = get_period(type);
+	float duty = CLAMP(get_parameter(type, 1, 0.5f), 0.0f, 1.0f);
+	schedule_toggle(pins[0], queue, current_time, cid, period, (tap_time_t)(period * duty), 0.0f, 1.0f);
+}
+
+void square_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: period, amplitude, duty. Toggles between -amplitude and amplitude
+	if (!is_own_tick(pins[0], current_time, cid)) {
+		return;
+	}
+
+	tap_time_t period = get_period(type);
+	float amplitude = get_parameter(type, 1, 1.0f);
+	float duty = CLAMP(get_parameter(type, 2, 0.5f), 0.0f, 1.0f);
+	schedule_toggle(pins[0], queue, current_time, cid, period, (tap_time_t)(period * duty), -amplitude, amplitude);
+}
+
+void pulse_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: period, width, amplitude. Rests at 0 and pulses to amplitude
+	if (!is_own_tick(pins[0], current_time, cid)) {
+		return;
+	}
+
+	tap_time_t period = get_period(type);
+	tap_time_t width = (tap_time_t)MAX(get_parameter(type, 1, 1024.0f), 1.0f);
+	float amplitude = get_parameter(type, 2, 1.0f);
+	schedule_toggle(pins[0], queue, current_time, cid, period, width, 0.0f, amplitude);
+}
+
+void saw_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: period, amplitude, step. Rises from -amplitude to amplitude
+	if (!is_own_tick(pins[0], current_time, cid)) {
+		return;
+	}
+
+	schedule_step(pins[0], queue, current_time, cid, type, [](float phase) {
+		return 2.0f * phase - 1.0f;
+	});
+}
+
+void sine_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: period, amplitude, step
+	if (!is_own_tick(pins[0], current_time, cid)) {
+		return;
+	}
+
+	schedule_step(pins[0], queue, current_time, cid, type, [](float phase) {
+		return (float)Math::sin(2.0 * Math::PI * phase);
+	});
+}
+
+//ticks between a stateful component seeing its inputs and driving its output
+static constexpr tap_time_t STATEFUL_DELAY = 1;
+//logic high starts here, the middle of a 0 to 1 swing
+static constexpr float LOGIC_THRESHOLD = 0.5f;
+
+static inline bool is_high(AudioFrame frame) {
+	return frame.left > LOGIC_THRESHOLD;
+}
+
+//true once per rising edge of `pin`, with the previous level kept in `level.left`
+static inline bool take_rising_edge(const tap_event_t *pin, AudioFrame &level) {
+	bool rising = is_high(pin->state) && !is_high(level);
+	level.left = pin->state.left;
+	return rising;
+}
+
+static inline void send(tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_event_t *pin, AudioFrame state) {
+	tap_time_t new_time = current_time + STATEFUL_DELAY;
+	queue.insert({ new_time, state, pin->pid, cid }, new_time);
+}
+
+void delay_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//pins: in, out. parameters: delay in ticks. Every input change reaches the
+	//output `delay` ticks later, the same as a chain of `delay` wires
+	if (pins[0]->time != current_time) {
+		return;
+	}
+
+	tap_time_t new_time = current_time + (tap_time_t)MAX(get_parameter(type, 0, 1024.0f), 1.0f);
+	queue.insert({ new_time, pins[0]->state, pins[1]->pid, cid }, new_time);
+}
+
+static int delay_line_length(const tap_component_type_t &type) {
+	return (int)MAX(get_parameter(type, 0, 16.0f), 1.0f);
+}
+
+static int delay_line_memory_size(const tap_component_type_t &type) {
+	return 1 + delay_line_length(type);
+}
+
+void delay_line_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//pins: in, clock, out. parameters: length. A shift register: each rising
+	//clock edge shifts `in` into a ring of `length` stages and the oldest out.
+	//memory: [clock level, head index in .right], then the ring
+	AudioFrame &header = memory[0];
+	if (!take_rising_edge(pins[1], header)) {
+		return;
+	}
+
+	int length = delay_line_length(type);
+	int head = (int)header.right;
+	head = head >= 0 && head < length ? head : 0;
+	AudioFrame *ring = memory + 1;
+
+	AudioFrame oldest = ring[head];
+	ring[head] = pins[0]->state;
+	header.right = (float)((head + 1) % length);
+
+	send(queue, current_time, cid, pins[2], oldest);
+}
+
+void d_latch_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//pins: d, enable, q. q follows d while enable is high and holds otherwise.
+	//memory: the last q sent, so an unchanged d costs nothing
+	if (!is_high(pins[1]->state)) {
+		return;
+	}
+
+	AudioFrame d = pins[0]->state;
+	if (d.left == memory[0].left && d.right == memory[0].right) {
+		return;
+	}
+
+	memory[0] = d;
+	send(queue, current_time, cid, pins[2], d);
+}
+
+void flip_flop_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//pins: d, clock, q. On a rising clock edge q takes d as a logic level.
+	//memory: the clock level
+	if (!take_rising_edge(pins[1], memory[0])) {
+		return;
+	}
+
+	AudioFrame d = pins[0]->state;
+	AudioFrame q(d.left > LOGIC_THRESHOLD ? 1.0f : 0.0f, d.right > LOGIC_THRESHOLD ? 1.0f : 0.0f);
+	send(queue, current_time, cid, pins[2], q);
+}
+
+void sample_hold_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//pins: in, trigger, out. On a rising trigger edge out takes in and holds it.
+	//memory: the trigger level
+	if (!take_rising_edge(pins[1], memory[0])) {
+		return;
+	}
+
+	send(queue, current_time, cid, pins[2], pins[0]->state);
+}
+
+static int single_slot_memory_size(const tap_component_type_t &type) {
+	return 1;
+}
+
+/*
+Sampled DSP shared plumbing. Memory starts with a header:
+	[0] held input
+	[1] last output sent
+	[2] time of the last sample, bit-cast into .left, and 1 in .right once
+	    there is one
+and each type's own state follows from SAMPLED_HEADER.
+
+Catch-up runs in blocks to keep the calls down, but only the FIR's tap loop
+vectorizes. The biquad, one-pole and envelope are recursions, so they still
+go a frame at a time.
+*/
+static constexpr int SAMPLED_HEADER = 3;
+//longest gap filled with held samples, which bounds the cost of one solve.
+//A one-pole or envelope with a small smoothing or release can still be
+//moving after this many samples, so after a longer gap it lags where an
+//unbounded catch-up would have put it
+static constexpr tap_time_t MAX_CATCH_UP = 4096;
+//samples filtered per pass while catching up
+static constexpr int CATCH_UP_BLOCK = 64;
+//a little over one tap_frame step
+static constexpr float DEFAULT_DSP_THRESHOLD = 1e-4f;
+
+static inline tap_time_t load_time(const AudioFrame &slot) {
+	tap_time_t time;
+	memcpy(&time, &slot.left, sizeof(time));
+	return time;
+}
+
+static inline void store_time(AudioFrame &slot, tap_time_t time) {
+	memcpy(&slot.left, &time, sizeof(time));
+}
+
+/*
+Run `process(buffer, count, state)` in place over the held input for the gap
+since the last sample, then over the new input, and send the result if it moved
+far enough. `process` filters a block of frames in place.
+*/
+template <typename F>
+static inline void run_sampled(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory, F &&process) {
+	if (pins[0]->time != current_time) {
+		return;
+	}
+
+	float threshold = get_parameter(type, 0, DEFAULT_DSP_THRESHOLD);
+	tap_time_t sample_period = (tap_time_t)MAX(get_parameter(type, 1, 0.0f), 0.0f);
+
+	AudioFrame &held = memory[0];
+	AudioFrame &sent = memory[1];
+	AudioFrame *state = memory + SAMPLED_HEADER;
+
+	//the first input has no earlier sample to hold, so there is no gap
+	bool has_sample = memory[2].right != 0.0f;
+	if (sample_period > 0 && has_sample) {
+		tap_time_t last_time = load_time(memory[2]);
+		tap_time_t gap = current_time > last_time ? (current_time - last_time) / sample_period : 0;
+		//the new input takes the last slot of the gap
+		gap = gap > 0 ? MIN(gap - 1, MAX_CATCH_UP) : 0;
+
+		AudioFrame buffer[CATCH_UP_BLOCK];
+		while (gap > 0) {
+			int count = (int)MIN(gap, (tap_time_t)CATCH_UP_BLOCK);
+			for (int i = 0; i < count; i++) {
+				buffer[i] = held;
+			}
+			process(buffer, count, state);
+			gap -= count;
+		}
+	}
+	store_time(memory[2], current_time);
+	memory[2].right = 1.0f;
+
+	AudioFrame out = pins[0]->state;
+	process(&out, 1, state);
+	held = pins[0]->state;
+
+	if (Math::abs(out.left - sent.left) <= threshold && Math::abs(out.right - sent.right) <= threshold) {
+		return;
+	}
+
+	sent = out;
+	send(queue, current_time, cid, pins[1], out);
+}
+
+static int biquad_memory_size(const tap_component_type_t &type) {
+	//coefficients (b0, b1), (b2, a1), (a2, designed), then z1, z2
+	return SAMPLED_HEADER + 5;
+}
+
+void biquad_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: threshold, sample_period, mode (0 low, 1 high, 2 band pass),
+	//cutoff as a fraction of the sample rate, q
+	AudioFrame *coefficients = memory + SAMPLED_HEADER;
+
+	tap_biquad_t biquad;
+	if (coefficients[2].right == 0.0f) {
+		int mode = (int)get_parameter(type, 2, 0.0f);
+		double cutoff = get_parameter(type, 3, 0.1f);
+		double q = MAX(get_parameter(type, 4, 0.70710678f), 0.01f);
+
+		biquad = mode == 1 ? tap_biquad_t::high_pass(cutoff, q) : (mode == 2 ? tap_biquad_t::band_pass(cutoff, q) : tap_biquad_t::low_pass(cutoff, q));
+		coefficients[0] = AudioFrame(biquad.b0, biquad.b1);
+		coefficients[1] = AudioFrame(biquad.b2, biquad.a1);
+		coefficients[2] = AudioFrame(biquad.a2, 1.0f);
+	} else {
+		biquad.b0 = coefficients[0].left;
+		biquad.b1 = coefficients[0].right;
+		biquad.b2 = coefficients[1].left;
+		biquad.a1 = coefficients[1].right;
+		biquad.a2 = coefficients[2].left;
+	}
+
+	run_sampled(pins, queue, current_time, cid, type, memory, [&](AudioFrame *buffer, int count, AudioFrame *state) {
+		tap_biquad_state_t delay{ state[3], state[4] };
+		biquad.process_block(buffer, count, delay);
+		state[3] = delay.z1;
+		state[4] = delay.z2;
+	});
+}
+
+static constexpr int MAX_FIR_TAPS = 64;
+
+static int fir_tap_count(const tap_component_type_t &type) {
+	return CLAMP(type.parameters.size() - 2, 1, MAX_FIR_TAPS);
+}
+
+static int fir_memory_size(const tap_component_type_t &type) {
+	//write index, then the history twice over so every window is contiguous
+	return SAMPLED_HEADER + 1 + 2 * fir_tap_count(type);
+}
+
+void fir_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: threshold, sample_period, then the taps, newest sample first.
+	//Without taps it passes the input through
+	int taps = fir_tap_count(type);
+	float coefficients[MAX_FIR_TAPS];
+	for (int k = 0; k < taps; k++) {
+		//reversed, to line up with the window running oldest to newest
+		coefficients[taps - 1 - k] = get_parameter(type, 2 + k, k == 0 ? 1.0f : 0.0f);
+	}
+
+	run_sampled(pins, queue, current_time, cid, type, memory, [&](AudioFrame *buffer, int count, AudioFrame *state) {
+		int head = (int)state[0].left;
+		head = head >= 0 && head < taps ? head : 0;
+		AudioFrame *history = state + 1;
+
+		for (int i = 0; i < count; i++) {
+			history[head] = buffer[i];
+			history[head + taps] = buffer[i];
+			head = head + 1 < taps ? head + 1 : 0;
+
+			//oldest sample is at head, newest at head + taps - 1
+			const AudioFrame *window = history + head;
+			float left = 0.0f, right = 0.0f;
+			for (int k = 0; k < taps; k++) {
+				left += coefficients[k] * window[k].left;
+				right += coefficients[k] * window[k].right;
+			}
+			buffer[i] = AudioFrame(left, right);
+		}
+
+		state[0].left = (float)head;
+	});
+}
+
+static int one_pole_memory_size(const tap_component_type_t &type) {
+	//the output
+	return SAMPLED_HEADER + 1;
+}
+
+void one_pole_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: threshold, sample_period, smoothing in (0, 1], the share of
+	//the distance to the input covered each sample
+	float smoothing = CLAMP(get_parameter(type, 2, 0.1f), 0.0f, 1.0f);
+
+	run_sampled(pins, queue, current_time, cid, type, memory, [&](AudioFrame *buffer, int count, AudioFrame *state) {
+		float left = state[0].left, right = state[0].right;
+		for (int i = 0; i < count; i++) {
+			left += smoothing * (buffer[i].left - left);
+			right += smoothing * (buffer[i].right - right);
+			buffer[i] = AudioFrame(left, right);
+		}
+		state[0] = AudioFrame(left, right);
+	});
+}
+
+void envelope_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//parameters: threshold, sample_period, attack, release. Follows the
+	//magnitude of the input, rising by `attack` and falling by `release` of the
+	//distance each sample
+	float attack = CLAMP(get_parameter(type, 2, 0.5f), 0.0f, 1.0f);
+	float release = CLAMP(get_parameter(type, 3, 0.01f), 0.0f, 1.0f);
+
+	run_sampled(pins, queue, current_time, cid, type, memory, [&](AudioFrame *buffer, int count, AudioFrame *state) {
+		float left = state[0].left, right = state[0].right;
+		for (int i = 0; i < count; i++) {
+			float magnitude_l = Math::abs(buffer[i].left);
+			float magnitude_r = Math::abs(buffer[i].right);
+			left += (magnitude_l > left ? attack : release) * (magnitude_l - left);
+			right += (magnitude_r > right ? attack : release) * (magnitude_r - right);
+			buffer[i] = AudioFrame(left, right);
+		}
+		state[0] = AudioFrame(left, right);
+	});
+}
+
+//ticks from an input change to the looked up outputs, the same as a gate
+static constexpr tap_time_t LUT_DELAY = 3;
+
+static inline int lut_index(float channel, int shift) {
+	return tap_frame::channel_to_bytes(channel) >> shift;
+}
+
+void lut_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	const float *parameters = type.parameters.ptr();
+	if (type.parameters.size() < 3) {
+		return;
+	}
+
+	int bits = (int)parameters[0];
+	int inputs = (int)parameters[1];
+	int outputs = (int)parameters[2];
+	const float *table = parameters + 3;
+	if (bits < 1 || bits > TapComponentType::MAX_LUT_BITS || inputs < 1 || inputs * bits > 30) {
+		return;
+	}
+	if (type.parameters.size() < 3 + ((int64_t)outputs << (inputs * bits)) || pins.size() < inputs + outputs) {
+		return;
+	}
+
+	int shift = 16 - bits;
+	int left = 0, right = 0;
+	for (int i = inputs - 1; i >= 0; i--) {
+		left = (left << bits) | lut_index(pins[i]->state.left, shift);
+		right = (right << bits) | lut_index(pins[i]->state.right, shift);
+	}
+
+	const float *left_entry = table + (size_t)left * outputs;
+	const float *right_entry = table + (size_t)right * outputs;
+	tap_time_t new_time = current_time + LUT_DELAY;
+	for (int o = 0; o < outputs; o++) {
+		queue.insert({ new_time, AudioFrame(left_entry[o], right_entry[o]), pins[inputs + o]->pid, cid }, new_time);
+	}
+}
+
+//ticks from an input change to the outputs, the same as a gate
+static constexpr tap_time_t EXPRESSION_DELAY = 3;
+
+void expression_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	const float *program = type.parameters.ptr();
+	if (!tap_expression_t::is_valid(program, type.parameters.size())) {
+		return;
+	}
+
+	int inputs = tap_expression_t::get_input_count(program);
+	int outputs = tap_expression_t::get_output_count(program);
+	if (pins.size() < inputs + outputs) {
+		return;
+	}
+
+	float left[tap_expression_t::MAX_REGISTERS];
+	float right[tap_expression_t::MAX_REGISTERS];
+	for (int i = 0; i < inputs; i++) {
+		left[i] = pins[i]->state.left;
+		right[i] = pins[i]->state.right;
+	}
+
+	const float *output_registers = tap_expression_t::run(program, left, right);
+
+	tap_time_t new_time = current_time + EXPRESSION_DELAY;
+	for (int o = 0; o < outputs; o++) {
+		int r = (int)output_registers[o];
+		if (r < 0) {
+			continue; //never assigned
+		}
+		r &= tap_expression_t::MAX_REGISTERS - 1;
+		queue.insert({ new_time, AudioFrame(left[r], right[r]), pins[inputs + o]->pid, cid }, new_time);
+	}
+}
+
+//ticks through a logic block or converter, the same as a gate
+static constexpr tap_time_t LOGIC_DELAY = 3;
+
+//per channel codes kept in memory for the last level sent. 0 means nothing sent yet
+static constexpr float LOGIC_CODE_LOW = 1.0f;
+static constexpr float LOGIC_CODE_HIGH = 2.0f;
+static constexpr float LOGIC_CODE_UNKNOWN = 3.0f;
+
+static inline float logic_code(bool high, bool known) {
+	return !known ? LOGIC_CODE_UNKNOWN : (high ? LOGIC_CODE_HIGH : LOGIC_CODE_LOW);
+}
+
+static inline float logic_level(float code) {
+	return code == LOGIC_CODE_HIGH ? tap_logic_t::HIGH_LEVEL : (code == LOGIC_CODE_UNKNOWN ? tap_logic_t::UNKNOWN_LEVEL : tap_logic_t::LOW_LEVEL);
+}
+
+//a logic pin's level as a code. X sits at -1, so anything below -0.5 reads as X
+static inline float read_logic_code(float channel) {
+	return channel > LOGIC_THRESHOLD ? LOGIC_CODE_HIGH : (channel < -LOGIC_THRESHOLD ? LOGIC_CODE_UNKNOWN : LOGIC_CODE_LOW);
+}
+
+static int logic_memory_size(const tap_component_type_t &type) {
+	const float *program = type.parameters.ptr();
+	return tap_logic_t::is_valid(program, type.parameters.size()) ? tap_logic_t::get_output_count(program) : 0;
+}
+
+void logic_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//memory: the last code sent per output
+	const float *program = type.parameters.ptr();
+	if (!tap_logic_t::is_valid(program, type.parameters.size())) {
+		return;
+	}
+
+	int inputs = tap_logic_t::get_input_count(program);
+	int outputs = tap_logic_t::get_output_count(program);
+	if (pins.size() < inputs + outputs || memory == nullptr) {
+		return;
+	}
+
+	//lane 0 is the left channel, lane 1 the right
+	uint64_t value[tap_logic_t::MAX_NETS];
+	uint64_t known[tap_logic_t::MAX_NETS];
+	for (int i = 0; i < inputs; i++) {
+		float left = read_logic_code(pins[i]->state.left);
+		float right = read_logic_code(pins[i]->state.right);
+		value[i] = (left == LOGIC_CODE_HIGH ? 1 : 0) | (right == LOGIC_CODE_HIGH ? 2 : 0);
+		known[i] = (left != LOGIC_CODE_UNKNOWN ? 1 : 0) | (right != LOGIC_CODE_UNKNOWN ? 2 : 0);
+	}
+
+	bool four_state = tap_logic_t::is_four_state(program);
+	const float *output_nets = four_state ? tap_logic_t::sweep_four_state(program, value, known) : tap_logic_t::sweep_two_state(program, value);
+
+	tap_time_t new_time = current_time + LOGIC_DELAY;
+	for (int o = 0; o < outputs; o++) {
+		int net = (int)output_nets[o] & (tap_logic_t::MAX_NETS - 1);
+		uint64_t k = four_state ? known[net] : ~(uint64_t)0;
+		AudioFrame code(logic_code(value[net] & 1, k & 1), logic_code(value[net] & 2, k & 2));
+		if (code.left == memory[o].left && code.right == memory[o].right) {
+			continue;
+		}
+
+		memory[o] = code;
+		queue.insert({ new_time, AudioFrame(logic_level(code.left), logic_level(code.right)), pins[inputs + o]->pid, cid }, new_time);
+	}
+}
+
+//schmitt trigger on tap_frame bytes, so the thresholds snap to what a pin can hold
+static inline float schmitt_code(float channel, tap_frame::bytes_t low, tap_frame::bytes_t high, float previous) {
+	tap_frame::bytes_t bytes = tap_frame::channel_to_bytes(channel);
+	if (bytes >= high) {
+		return LOGIC_CODE_HIGH;
+	}
+	if (bytes <= low) {
+		return LOGIC_CODE_LOW;
+	}
+	return previous == 0.0f ? LOGIC_CODE_LOW : previous;
+}
+
+void analog_to_logic_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//memory: the last code sent
+	tap_frame::bytes_t low = tap_frame::channel_to_bytes(get_parameter(type, 0, 0.4f));
+	tap_frame::bytes_t high = tap_frame::channel_to_bytes(get_parameter(type, 1, 0.6f));
+	high = MAX(high, low);
+
+	AudioFrame state = pins[0]->state;
+	AudioFrame code(schmitt_code(state.left, low, high, memory[0].left), schmitt_code(state.right, low, high, memory[0].right));
+	if (code.left == memory[0].left && code.right == memory[0].right) {
+		return;
+	}
+
+	memory[0] = code;
+	tap_time_t new_time = current_time + LOGIC_DELAY;
+	queue.insert({ new_time, AudioFrame(logic_level(code.left), logic_level(code.right)), pins[1]->pid, cid }, new_time);
+}
+
+static inline float analog_level(float code, const tap_component_type_t &type) {
+	if (code == LOGIC_CODE_HIGH) {
+		return get_parameter(type, 1, 1.0f);
+	}
+	return code == LOGIC_CODE_UNKNOWN ? get_parameter(type, 2, 0.0f) : get_parameter(type, 0, 0.0f);
+}
+
+void logic_to_analog_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory) {
+	//memory: the last code sent
+	AudioFrame state = pins[0]->state;
+	AudioFrame code(read_logic_code(state.left), read_logic_code(state.right));
+	if (code.left == memory[0].left && code.right == memory[0].right) {
+		return;
+	}
+
+	memory[0] = code;
+	tap_time_t new_time = current_time + LOGIC_DELAY;
+	queue.insert({ new_time, AudioFrame(analog_level(code.left, type), analog_level(code.right, type)), pins[1]->pid, cid }, new_time);
+}
+
 void TapComponentType::initialize_solver_registry_internal() {
 	solver_registry.clear();
 	solver_registry.insert("wire", &wire_solver);
 	solver_registry.insert("none", &none_solver);
 	solver_registry.insert("mixer", &mixer_solver);
 	solver_registry.insert("gate", &gate_solver);
+
+	solver_registry.insert("clock", &clock_solver);
+	solver_registry.insert("square", &square_solver);
+	solver_registry.insert("pulse", &pulse_solver);
+	solver_registry.insert("saw", &saw_solver);
+	solver_registry.insert("sine", &sine_solver);
+
+	solver_registry.insert("delay", &delay_solver);
+	solver_registry.insert("delay_line", &delay_line_solver);
+	solver_registry.insert("d_latch", &d_latch_solver);
+	solver_registry.insert("flip_flop", &flip_flop_solver);
+	solver_registry.insert("sample_hold", &sample_hold_solver);
+
+	solver_registry.insert("biquad", &biquad_solver);
+	solver_registry.insert("fir", &fir_solver);
+	solver_registry.insert("one_pole", &one_pole_solver);
+	solver_registry.insert("envelope", &envelope_solver);
+
+	solver_registry.insert("lut", &lut_solver);
+	solver_registry.insert("expression", &expression_solver);
+
+	solver_registry.insert("logic", &logic_solver);
+	solver_registry.insert("analog_to_logic", &analog_to_logic_solver);
+	solver_registry.insert("logic_to_analog", &logic_to_analog_solver);
+
+	self_scheduling_registry.clear();
+	self_scheduling_registry.insert("clock");
+	self_scheduling_registry.insert("square");
+	self_scheduling_registry.insert("pulse");
+	self_scheduling_registry.insert("saw");
+	self_scheduling_registry.insert("sine");
+
+	memory_size_registry.clear();
+	memory_size_registry.insert("delay_line", &delay_line_memory_size);
+	memory_size_registry.insert("d_latch", &single_slot_memory_size);
+	memory_size_registry.insert("flip_flop", &single_slot_memory_size);
+	memory_size_registry.insert("sample_hold", &single_slot_memory_size);
+	memory_size_registry.insert("biquad", &biquad_memory_size);
+	memory_size_registry.insert("fir", &fir_memory_size);
+	memory_size_registry.insert("one_pole", &one_pole_memory_size);
+	memory_size_registry.insert("envelope", &one_pole_memory_size);
+	memory_size_registry.insert("logic", &logic_memory_size);
+	memory_size_registry.insert("analog_to_logic", &single_slot_memory_size);
+	memory_size_registry.insert("logic_to_analog", &single_slot_memory_size);
+
 	print_line(vformat("TapComponentType: Registered %d solver functions.", TapComponentType::solver_registry.size()));
 }
 
 void TapComponentType::uninitialize_solver_registry_internal() {
 	solver_registry.clear();
+	self_scheduling_registry.clear();
+	memory_size_registry.clear();
 }
\ No newline at end of file
@@ -1,16 +1,98 @@
 #pragma once
 
 #include "core/io/resource.h"
+#include "core/templates/hash_set.h"
 
 #include "tap_circuit_types.h"
 
-void wire_solver(const Vector<const tap_event_t *> &state, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid);
+void wire_solver(const Vector<const tap_event_t *> &state, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
 
-void none_solver(const Vector<const tap_event_t *> &state, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid);
+void none_solver(const Vector<const tap_event_t *> &state, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
 
-void mixer_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid);
+void mixer_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
 
-void gate_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid);
+void gate_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+/*
+Sources. Each drives a single pin and schedules its own next transition there,
+so they need TapCircuit::start_sources to send the first event. Periods and
+widths are in simulation ticks.
+*/
+
+void clock_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void square_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void pulse_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void saw_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void sine_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+/*
+Stateful components. Edges are detected against the level kept in memory, so
+they fire once per transition whichever pins the type is sensitive to.
+*/
+
+void delay_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void delay_line_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void d_latch_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void flip_flop_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void sample_hold_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+/*
+Sampled DSP. Pins: in, out. Each input event is one sample. If the
+`sample_period` parameter is set, the time since the last input is also filled
+with the held input, one sample per period, so change-driven inputs filter the
+same as sampled ones. The first input after a reset has nothing to fill from,
+and gaps are capped at 4096 samples. The output is only sent when it moves more than the
+`threshold` parameter from the last value sent. Output ringing between inputs
+is caught up on at the next input.
+
+Parameters start with threshold, sample_period, then each type's own.
+*/
+
+void biquad_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void fir_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void one_pole_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+void envelope_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+/*
+Lookup table over quantized input levels, baked by TapComponentType::bake_lut_*.
+Pins: the inputs, then the outputs. Parameters: bits per input, input count,
+output count, then the table. Each channel is looked up on its own, so an
+output costs one indexed load per channel.
+*/
+void lut_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+/*
+Runs the program compiled from TapComponentType::set_expression, see
+tap_expression.h. Pins: the inputs, then the outputs.
+*/
+void expression_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+/*
+Digital domain. Logic pins carry 0 for low, 1 for high and -1 for X. A logic
+block evaluates a whole compiled gate netlist (see tap_logic.h and
+TapComponentType::compile_logic) in one levelized sweep, with the left and
+right channels as two lanes of each word. Outputs are only sent when they
+change. The converters bridge to analog pins. Pins: in, out.
+*/
+
+void logic_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+//parameters: low and high thresholds. Between them the last level holds
+void analog_to_logic_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
+
+//parameters: analog levels for low, high and X
+void logic_to_analog_solver(const Vector<const tap_event_t *> &pins, tap_queue_t &queue, tap_time_t current_time, tap_label_t cid, const tap_component_type_t &type, AudioFrame *memory);
 
 /*
 Define a resource wrapper for tap_component_type_t, allowing the user to
@@ -28,6 +110,16 @@ class TapComponentType : public Resource {
 		&wire_solver, //default to wire solver
 	};
 	StringName solver_function_name = "wire";
+	//source of the compiled program, while the expression solver is in use
+	String expression;
+
+	//size memory for the current solver and parameters
+	void update_memory_size_internal();
+
+	//checks shared by the bake_lut_* functions. Sets r_levels to the input level combinations
+	Error prepare_lut_internal(int inputs, int outputs, int bits, int &r_levels);
+	//switch to a solver whose pins are `inputs` sensitive inputs then `outputs` outputs
+	void install_internal(StringName solver_name, int inputs, int outputs, const Vector<float> &new_parameters);
 
 protected:
 	static void _bind_methods();
@@ -45,6 +137,69 @@ public:
 	void set_solver_function(StringName solver_name);
 	StringName get_solver_function_name();
 
+	void set_parameters(const Vector<float> &new_parameters);
+	Vector<float> get_parameters() const;
+
+	bool is_self_scheduling() const;
+	int get_memory_size() const;
+
+	/*
+	Turn this type into a lookup table with `bits` of resolution per input,
+	sampling `source`'s solver at the middle of every input level. The first
+	`inputs` pins of `source` are its inputs and the rest its outputs. Each
+	sample sees fresh memory, so only stateless behavior carries over.
+	*/
+	Error bake_lut_from_type(Ref<TapComponentType> source, int inputs, int bits);
+
+	/*
+	Turn this type into a lookup table with `bits` of resolution per input,
+	calling `function` once per input level combination. It takes a
+	PackedFloat32Array of `inputs` levels and returns `outputs` levels. Runs
+	now, never on the audio thread.
+	*/
+	Error bake_lut_from_callable(const Callable &function, int inputs, int outputs, int bits);
+
+	/*
+	Compile `new_expression` and switch over to the expression solver. Pins
+	become in0, in1... followed by out0, out1..., as many as the expression
+	names. On a compile error the type is left as it was. Clearing the
+	expression, or picking another solver, leaves the current program alone.
+	*/
+	void set_expression(const String &new_expression);
+	String get_expression() const;
+
+	enum LogicOp {
+		LOGIC_BUF,
+		LOGIC_NOT,
+		LOGIC_AND,
+		LOGIC_OR,
+		LOGIC_XOR,
+		LOGIC_NAND,
+		LOGIC_NOR,
+		LOGIC_XNOR,
+		LOGIC_MUX,
+	};
+
+	/*
+	Compile a gate netlist and switch over to the logic solver. `gates` holds
+	op, a, b, c per gate, where nets 0 to `inputs` - 1 are the inputs and each
+	gate drives the next net after them. MUX outputs b where c is high, a
+	elsewhere. `outputs` lists the nets driving the output pins. Fails on a
+	combinational loop.
+	*/
+	Error compile_logic(int inputs, const PackedInt32Array &gates, const PackedInt32Array &outputs, bool four_state = false);
+
+	/*
+	Evaluate the compiled logic block for 64 input patterns at once, one bit
+	per pattern in each input's word. Set bits of `unknown_words` mark X inputs.
+	Returns a word per output, followed in four-state mode by each output's
+	unknown word.
+	*/
+	PackedInt64Array evaluate_logic(const PackedInt64Array &input_words, const PackedInt64Array &unknown_words = PackedInt64Array()) const;
+
+	static constexpr int MAX_LUT_BITS = 12;
+	static constexpr int MAX_LUT_ENTRIES = 1 << 22;
+
 	void set_component_type_internal(tap_component_type_t new_component_type);
 	tap_component_type_t get_component_type_internal() const;
 
@@ -52,6 +207,14 @@ public:
 	static void uninitialize_solver_registry_internal();
 
 	static HashMap<StringName, tap_component_type_t::solver_t> solver_registry;
+	//solvers in the registry that schedule themselves, see tap_component_type_t
+	static HashSet<StringName> self_scheduling_registry;
+
+	//memory slots a component needs, for solvers in the registry that keep any
+	using memory_size_t = int (*)(const tap_component_type_t &type);
+	static HashMap<StringName, memory_size_t> memory_size_registry;
 
 	TapComponentType() = default;
-};
\ No newline at end of file
+};
+
+VARIANT_ENUM_CAST(TapComponentType::LogicOp);
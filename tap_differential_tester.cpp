@@ -0,0 +1,409 @@
+#include "core/math/random_pcg.h"
+#include "core/object/class_db.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/os/os.h"
+#include "core/templates/hash_map.h"
+
+#include "tap_differential_tester.h"
+#include "tap_patch_bay.h"
+
+void TapDifferentialTester::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_circuit"), &TapDifferentialTester::get_circuit);
+	ClassDB::bind_method(D_METHOD("set_circuit", "new_circuit"), &TapDifferentialTester::set_circuit);
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "circuit", PROPERTY_HINT_RESOURCE_TYPE, "TapCircuit"), "set_circuit", "get_circuit");
+
+	ClassDB::bind_method(D_METHOD("get_reference_sim"), &TapDifferentialTester::get_reference_sim);
+	ClassDB::bind_method(D_METHOD("set_reference_sim", "new_reference_sim"), &TapDifferentialTester::set_reference_sim);
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "reference_sim", PROPERTY_HINT_RESOURCE_TYPE, "ReferenceSim"), "set_reference_sim", "get_reference_sim");
+
+	ClassDB::bind_method(D_METHOD("get_input_pids"), &TapDifferentialTester::get_input_pids);
+	ClassDB::bind_method(D_METHOD("set_input_pids", "pids"), &TapDifferentialTester::set_input_pids);
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT64_ARRAY, "input_pids"), "set_input_pids", "get_input_pids");
+
+	ClassDB::bind_method(D_METHOD("get_output_pids"), &TapDifferentialTester::get_output_pids);
+	ClassDB::bind_method(D_METHOD("set_output_pids", "pids"), &TapDifferentialTester::set_output_pids);
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT64_ARRAY, "output_pids"), "set_output_pids", "get_output_pids");
+
+	ClassDB::bind_method(D_METHOD("get_seed"), &TapDifferentialTester::get_seed);
+	ClassDB::bind_method(D_METHOD("set_seed", "new_seed"), &TapDifferentialTester::set_seed);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "seed"), "set_seed", "get_seed");
+
+	ClassDB::bind_method(D_METHOD("get_trials"), &TapDifferentialTester::get_trials);
+	ClassDB::bind_method(D_METHOD("set_trials", "new_trials"), &TapDifferentialTester::set_trials);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "trials", PROPERTY_HINT_RANGE, "1,65536,1,or_greater"), "set_trials", "get_trials");
+
+	ClassDB::bind_method(D_METHOD("get_trial_seconds"), &TapDifferentialTester::get_trial_seconds);
+	ClassDB::bind_method(D_METHOD("set_trial_seconds", "seconds"), &TapDifferentialTester::set_trial_seconds);
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "trial_seconds"), "set_trial_seconds", "get_trial_seconds");
+
+	ClassDB::bind_method(D_METHOD("get_mix_rate"), &TapDifferentialTester::get_mix_rate);
+	ClassDB::bind_method(D_METHOD("set_mix_rate", "new_mix_rate"), &TapDifferentialTester::set_mix_rate);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "mix_rate"), "set_mix_rate", "get_mix_rate");
+
+	ClassDB::bind_method(D_METHOD("get_tick_rate"), &TapDifferentialTester::get_tick_rate);
+	ClassDB::bind_method(D_METHOD("set_tick_rate", "new_tick_rate"), &TapDifferentialTester::set_tick_rate);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "tick_rate"), "set_tick_rate", "get_tick_rate");
+
+	ClassDB::bind_method(D_METHOD("get_sample_skip"), &TapDifferentialTester::get_sample_skip);
+	ClassDB::bind_method(D_METHOD("set_sample_skip", "new_sample_skip"), &TapDifferentialTester::set_sample_skip);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "sample_skip"), "set_sample_skip", "get_sample_skip");
+
+	ClassDB::bind_method(D_METHOD("get_settle_ticks"), &TapDifferentialTester::get_settle_ticks);
+	ClassDB::bind_method(D_METHOD("set_settle_ticks", "ticks"), &TapDifferentialTester::set_settle_ticks);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "settle_ticks"), "set_settle_ticks", "get_settle_ticks");
+
+	ClassDB::bind_method(D_METHOD("get_max_hold_frames"), &TapDifferentialTester::get_max_hold_frames);
+	ClassDB::bind_method(D_METHOD("set_max_hold_frames", "frames"), &TapDifferentialTester::set_max_hold_frames);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_hold_frames"), "set_max_hold_frames", "get_max_hold_frames");
+
+	ClassDB::bind_method(D_METHOD("get_tolerance"), &TapDifferentialTester::get_tolerance);
+	ClassDB::bind_method(D_METHOD("set_tolerance", "new_tolerance"), &TapDifferentialTester::set_tolerance);
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "tolerance"), "set_tolerance", "get_tolerance");
+
+	ClassDB::bind_method(D_METHOD("run"), &TapDifferentialTester::run);
+}
+
+Ref<TapCircuit> TapDifferentialTester::get_circuit() const {
+	return circuit;
+}
+
+void TapDifferentialTester::set_circuit(Ref<TapCircuit> new_circuit) {
+	circuit = new_circuit;
+}
+
+Ref<ReferenceSim> TapDifferentialTester::get_reference_sim() const {
+	return reference_sim;
+}
+
+void TapDifferentialTester::set_reference_sim(Ref<ReferenceSim> new_reference_sim) {
+	reference_sim = new_reference_sim;
+}
+
+PackedInt64Array TapDifferentialTester::get_input_pids() const {
+	return input_pids;
+}
+
+void TapDifferentialTester::set_input_pids(const PackedInt64Array &pids) {
+	input_pids = pids;
+}
+
+PackedInt64Array TapDifferentialTester::get_output_pids() const {
+	return output_pids;
+}
+
+void TapDifferentialTester::set_output_pids(const PackedInt64Array &pids) {
+	output_pids = pids;
+}
+
+int64_t TapDifferentialTester::get_seed() const {
+	return seed;
+}
+
+void TapDifferentialTester::set_seed(int64_t new_seed) {
+	seed = new_seed;
+}
+
+int TapDifferentialTester::get_trials() const {
+	return trials;
+}
+
+void TapDifferentialTester::set_trials(int new_trials) {
+	trials = MAX(new_trials, 1);
+}
+
+double TapDifferentialTester::get_trial_seconds() const {
+	return trial_seconds;
+}
+
+void TapDifferentialTester::set_trial_seconds(double seconds) {
+	trial_seconds = MAX(seconds, 0.0);
+}
+
+int TapDifferentialTester::get_mix_rate() const {
+	return mix_rate;
+}
+
+void TapDifferentialTester::set_mix_rate(int new_mix_rate) {
+	mix_rate = MAX(new_mix_rate, 1);
+}
+
+int TapDifferentialTester::get_tick_rate() const {
+	return tick_rate;
+}
+
+void TapDifferentialTester::set_tick_rate(int new_tick_rate) {
+	tick_rate = MAX(new_tick_rate, 1);
+}
+
+int TapDifferentialTester::get_sample_skip() const {
+	return sample_skip;
+}
+
+void TapDifferentialTester::set_sample_skip(int new_sample_skip) {
+	sample_skip = MAX(new_sample_skip, 1);
+}
+
+int TapDifferentialTester::get_settle_ticks() const {
+	return settle_ticks;
+}
+
+void TapDifferentialTester::set_settle_ticks(int ticks) {
+	settle_ticks = MAX(ticks, 0);
+}
+
+int TapDifferentialTester::get_max_hold_frames() const {
+	return max_hold_frames;
+}
+
+void TapDifferentialTester::set_max_hold_frames(int frames) {
+	max_hold_frames = MAX(frames, 1);
+}
+
+float TapDifferentialTester::get_tolerance() const {
+	return tolerance;
+}
+
+void TapDifferentialTester::set_tolerance(float new_tolerance) {
+	tolerance = MAX(new_tolerance, 0.0f);
+}
+
+uint64_t TapDifferentialTester::trial_seed_internal(int64_t base_seed, uint32_t index) {
+	//splitmix64, so neighbouring trials get unrelated streams
+	uint64_t z = (uint64_t)base_seed + (uint64_t)(index + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+struct event_time_less_t {
+	bool operator()(const tap_event_t &a, const tap_event_t &b) const {
+		return a.time < b.time || (a.time == b.time && a.pid < b.pid);
+	}
+};
+
+LocalVector<tap_event_t> TapDifferentialTester::generate_inputs_internal(uint64_t trial_seed, int64_t frames) const {
+	RandomPCG rng(trial_seed);
+	LocalVector<tap_event_t> events;
+
+	for (int i = 0; i < input_pids.size(); i++) {
+		tap_label_t pid = (tap_label_t)input_pids[i];
+
+		//piecewise constant levels. Half of them are full scale, which is where
+		//clipping and carries show up.
+		for (int64_t frame = 0; frame < frames;) {
+			AudioFrame level;
+			if (rng.rand() % 2 == 0) {
+				level = AudioFrame(rng.rand() % 2 ? 1.0f : -1.0f, rng.rand() % 2 ? 1.0f : -1.0f);
+			} else {
+				level = AudioFrame(rng.randf() * 2.0f - 1.0f, rng.randf() * 2.0f - 1.0f);
+			}
+			events.push_back(tap_event_t{ (tap_time_t)(frame * tick_rate), level, pid, TapPatchBay::COMPONENT_MISSING });
+
+			int64_t hold = 1 + rng.rand() % max_hold_frames;
+			frame += (hold + sample_skip - 1) / sample_skip * sample_skip;
+		}
+	}
+
+	events.sort_custom<event_time_less_t>();
+	return events;
+}
+
+TapDifferentialTester::trial_result_t TapDifferentialTester::simulate_internal(const LocalVector<tap_event_t> &events, int64_t frames) const {
+	trial_result_t result;
+
+	Ref<TapCircuit> clone = circuit->clone_internal();
+	std::lock_guard<std::recursive_mutex> lock(clone->get_mutex());
+	Ref<TapPatchBay> patch_bay = clone->get_patch_bay();
+
+	//every trial starts from the pins' initial states and cleared component
+	//memory with its sources running, whatever the circuit was last left in
+	patch_bay->reset_pin_states_internal();
+	clone->get_network()->reset_memory_internal();
+	clone->start_sources(0);
+
+	//events arrive sorted by time, so each pid's share is already a run
+	HashMap<tap_label_t, LocalVector<tap_event_t>> runs;
+	for (const tap_event_t &event : events) {
+		runs[event.pid].push_back(event);
+	}
+	for (KeyValue<tap_label_t, LocalVector<tap_event_t>> &kv : runs) {
+		clone->push_event_run(kv.key, kv.value);
+	}
+
+	LocalVector<AudioFrame> problem;
+	LocalVector<AudioFrame> solution;
+	problem.resize(input_pids.size());
+	solution.resize(output_pids.size());
+
+	for (int64_t frame = 0; frame < frames; frame += sample_skip) {
+		tap_time_t time = (tap_time_t)(frame * tick_rate);
+		int count = 0;
+
+		clone->process_to_internal(time, -1, 0, count);
+		for (int i = 0; i < input_pids.size(); i++) {
+			problem[i] = patch_bay->get_pin_state_internal((tap_label_t)input_pids[i]);
+		}
+
+		clone->process_to_internal(time + settle_ticks, -1, 0, count);
+		result.events_processed += count;
+		for (int i = 0; i < output_pids.size(); i++) {
+			solution[i] = patch_bay->get_pin_state_internal((tap_label_t)output_pids[i]);
+		}
+
+		AudioFrame error = reference_func(solution, problem);
+		float worst = MAX(Math::abs(error.left), Math::abs(error.right));
+		if (worst > result.worst_error || result.worst_frame < 0) {
+			result.worst_error = worst;
+			result.worst_frame = frame;
+		}
+		if (worst > tolerance && result.first_failure_frame < 0) {
+			result.first_failure_frame = frame;
+		}
+	}
+
+	return result;
+}
+
+LocalVector<tap_event_t> TapDifferentialTester::minimize_internal(const LocalVector<tap_event_t> &events, int64_t frames) const {
+	int runs = 0;
+	auto fails = [&](const LocalVector<tap_event_t> &candidate) {
+		runs++;
+		return simulate_internal(candidate, frames).first_failure_frame >= 0;
+	};
+
+	//ddmin: drop chunks of the trace while it keeps failing, halving the
+	//chunks whenever nothing can be dropped
+	LocalVector<tap_event_t> current = events;
+	uint32_t granularity = 2;
+
+	while (current.size() >= 2 && runs < MAX_MINIMIZE_RUNS) {
+		uint32_t chunk = (current.size() + granularity - 1) / granularity;
+		bool reduced = false;
+
+		for (uint32_t start = 0; start < current.size() && runs < MAX_MINIMIZE_RUNS; start += chunk) {
+			uint32_t end = MIN(start + chunk, current.size());
+
+			LocalVector<tap_event_t> subset;
+			for (uint32_t i = start; i < end; i++) {
+				subset.push_back(current[i]);
+			}
+			if (fails(subset)) {
+				current = subset;
+				granularity = 2;
+				reduced = true;
+				break;
+			}
+
+			LocalVector<tap_event_t> complement;
+			for (uint32_t i = 0; i < current.size(); i++) {
+				if (i < start || i >= end) {
+					complement.push_back(current[i]);
+				}
+			}
+			if (fails(complement)) {
+				current = complement;
+				granularity = MAX(granularity - 1, 2u);
+				reduced = true;
+				break;
+			}
+		}
+
+		if (!reduced) {
+			if (granularity >= current.size()) {
+				break;
+			}
+			granularity = MIN(granularity * 2, current.size());
+		}
+	}
+
+	return current;
+}
+
+void TapDifferentialTester::run_trial_task(uint32_t index, int64_t base_seed) {
+	LocalVector<tap_event_t> events = generate_inputs_internal(trial_seed_internal(base_seed, index), trial_frames);
+	trial_results[index] = simulate_internal(events, trial_frames);
+}
+
+Dictionary TapDifferentialTester::run() {
+	Dictionary report;
+
+	ERR_FAIL_COND_V_MSG(circuit.is_null() || !circuit->is_instantiated(), report, "TapDifferentialTester::run: circuit is not set up.");
+	ERR_FAIL_COND_V_MSG(reference_sim.is_null(), report, "TapDifferentialTester::run: reference_sim is not set.");
+
+	StringName reference_name = reference_sim->get_reference_sim_name();
+	ERR_FAIL_COND_V_MSG(!ReferenceSim::reference_registry.has(reference_name), report, "TapDifferentialTester::run: reference '" + String(reference_name) + "' is not registered.");
+	reference_func = ReferenceSim::reference_registry[reference_name];
+
+	Ref<TapPatchBay> patch_bay = circuit->get_patch_bay();
+	for (int i = 0; i < input_pids.size(); i++) {
+		ERR_FAIL_COND_V_MSG(!patch_bay->has_pin(input_pids[i]), report, "TapDifferentialTester::run: input pid " + itos(input_pids[i]) + " does not exist.");
+	}
+	for (int i = 0; i < output_pids.size(); i++) {
+		ERR_FAIL_COND_V_MSG(!patch_bay->has_pin(output_pids[i]), report, "TapDifferentialTester::run: output pid " + itos(output_pids[i]) + " does not exist.");
+	}
+
+	if (settle_ticks >= sample_skip * tick_rate) {
+		WARN_PRINT("TapDifferentialTester::run: settle_ticks reaches the next input change, outputs will be compared against newer inputs.");
+	}
+
+	trial_frames = (int64_t)(trial_seconds * mix_rate);
+	ERR_FAIL_COND_V_MSG(trial_frames * tick_rate + settle_ticks > (int64_t)UINT32_MAX, report, "TapDifferentialTester::run: trial_seconds is too long for the circuit's time at this mix_rate and tick_rate.");
+	trial_results.clear();
+	trial_results.resize(trials);
+
+	uint64_t start_usec = OS::get_singleton()->get_ticks_usec();
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(this, &TapDifferentialTester::run_trial_task, seed, trials, -1, true, "TapDifferentialTester");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	uint64_t wall_usec = OS::get_singleton()->get_ticks_usec() - start_usec;
+
+	int failures = 0;
+	int worst_trial = 0;
+	int64_t events_processed = 0;
+	for (int i = 0; i < trials; i++) {
+		const trial_result_t &result = trial_results[i];
+		events_processed += result.events_processed;
+		if (result.first_failure_frame >= 0) {
+			failures++;
+		}
+		if (result.worst_error > trial_results[worst_trial].worst_error) {
+			worst_trial = i;
+		}
+	}
+
+	const trial_result_t &worst = trial_results[worst_trial];
+	report["trials"] = trials;
+	report["failures"] = failures;
+	report["simulated_seconds"] = trial_seconds * trials;
+	report["wall_usec"] = (int64_t)wall_usec;
+	report["events_processed"] = events_processed;
+	report["worst_error"] = worst.worst_error;
+	report["worst_trial"] = worst_trial;
+	report["worst_seed"] = (int64_t)trial_seed_internal(seed, worst_trial);
+	report["worst_frame"] = worst.worst_frame;
+
+	if (worst.first_failure_frame >= 0) {
+		//nothing after the first failure can have caused it
+		int64_t frames = worst.first_failure_frame + 1;
+		LocalVector<tap_event_t> events = generate_inputs_internal(trial_seed_internal(seed, worst_trial), trial_frames);
+		LocalVector<tap_event_t> prefix;
+		for (const tap_event_t &event : events) {
+			if (event.time <= (tap_time_t)(worst.first_failure_frame * tick_rate)) {
+				prefix.push_back(event);
+			}
+		}
+
+		Array trace;
+		for (const tap_event_t &event : minimize_internal(prefix, frames)) {
+			Dictionary entry;
+			entry["time"] = event.time;
+			entry["pid"] = event.pid;
+			entry["state"] = Vector2(event.state.left, event.state.right);
+			trace.push_back(entry);
+		}
+		report["minimized_trace"] = trace;
+	}
+
+	return report;
+}
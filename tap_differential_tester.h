@@ -0,0 +1,133 @@
+#pragma once
+
+#include "core/object/ref_counted.h"
+#include "core/templates/local_vector.h"
+#include "core/variant/dictionary.h"
+
+#include "reference_sim.h"
+#include "tap_circuit.h"
+#include "tap_circuit_types.h"
+
+/**
+ * @brief Offline differential tester: runs a TapCircuit and a ReferenceSim
+ * reference function side by side on generated inputs.
+ *
+ * Every trial gets its own input streams from `seed` and its trial index, so a
+ * failing trial replays exactly. Trials run across the WorkerThreadPool, each
+ * on its own clone of `circuit` with its pins back at their initial states. The reference function is called directly,
+ * so `reference_sim`'s own running totals are left alone.
+ *
+ * The worst failing trial's input is then minimized by delta debugging down to
+ * a small trace that still exceeds `tolerance`.
+ *
+ * @param circuit The circuit under test. Only read, never simulated.
+ * @param reference_sim Names the reference function to compare against.
+ * @param input_pids Pins the generated streams drive, the reference's problem.
+ * @param output_pids Pins read as the reference's solution.
+ * @param seed Base seed for input generation.
+ * @param trials Number of independent trials.
+ * @param trial_seconds Simulated length of each trial. Its ticks, plus
+ * `settle_ticks`, have to fit in tap_time_t, about 95 s at the defaults.
+ * @param mix_rate Frames per simulated second.
+ * @param tick_rate Circuit ticks per frame.
+ * @param sample_skip Frames between input changes and comparisons.
+ * @param settle_ticks Ticks the circuit gets to settle after each frame's
+ * inputs before the outputs are compared.
+ * @param max_hold_frames Longest an input holds one level.
+ * @param tolerance Largest error per channel that still counts as a pass.
+ */
+class TapDifferentialTester : public RefCounted {
+	GDCLASS(TapDifferentialTester, RefCounted);
+
+	Ref<TapCircuit> circuit;
+	Ref<ReferenceSim> reference_sim;
+	PackedInt64Array input_pids;
+	PackedInt64Array output_pids;
+
+	int64_t seed = 0;
+	int trials = 64;
+	double trial_seconds = 1.0;
+	int mix_rate = 44100;
+	int tick_rate = 1024;
+	int sample_skip = 2;
+	int settle_ticks = 512;
+	int max_hold_frames = 256;
+	float tolerance = 1e-4f;
+
+	//caps the reruns spent minimizing a failure
+	static constexpr int MAX_MINIMIZE_RUNS = 512;
+
+	struct trial_result_t {
+		float worst_error = 0.0f;
+		int64_t worst_frame = -1;
+		int64_t first_failure_frame = -1;
+		int64_t events_processed = 0;
+	};
+
+	//filled by the worker threads, one slot per trial
+	LocalVector<trial_result_t> trial_results;
+	ReferenceErrorFunc reference_func = nullptr;
+	int64_t trial_frames = 0;
+
+	LocalVector<tap_event_t> generate_inputs_internal(uint64_t trial_seed, int64_t frames) const;
+	trial_result_t simulate_internal(const LocalVector<tap_event_t> &events, int64_t frames) const;
+	LocalVector<tap_event_t> minimize_internal(const LocalVector<tap_event_t> &events, int64_t frames) const;
+
+	void run_trial_task(uint32_t index, int64_t base_seed);
+	static uint64_t trial_seed_internal(int64_t base_seed, uint32_t index);
+
+protected:
+	static void _bind_methods();
+
+public:
+	Ref<TapCircuit> get_circuit() const;
+	void set_circuit(Ref<TapCircuit> new_circuit);
+
+	Ref<ReferenceSim> get_reference_sim() const;
+	void set_reference_sim(Ref<ReferenceSim> new_reference_sim);
+
+	PackedInt64Array get_input_pids() const;
+	void set_input_pids(const PackedInt64Array &pids);
+
+	PackedInt64Array get_output_pids() const;
+	void set_output_pids(const PackedInt64Array &pids);
+
+	int64_t get_seed() const;
+	void set_seed(int64_t new_seed);
+
+	int get_trials() const;
+	void set_trials(int new_trials);
+
+	double get_trial_seconds() const;
+	void set_trial_seconds(double seconds);
+
+	int get_mix_rate() const;
+	void set_mix_rate(int new_mix_rate);
+
+	int get_tick_rate() const;
+	void set_tick_rate(int new_tick_rate);
+
+	int get_sample_skip() const;
+	void set_sample_skip(int new_sample_skip);
+
+	int get_settle_ticks() const;
+	void set_settle_ticks(int ticks);
+
+	int get_max_hold_frames() const;
+	void set_max_hold_frames(int frames);
+
+	float get_tolerance() const;
+	void set_tolerance(float new_tolerance);
+
+	/**
+	 * @brief Run every trial and report.
+	 *
+	 * Returns "trials", "failures", "simulated_seconds", "wall_usec",
+	 * "events_processed", "worst_error", "worst_trial", "worst_seed" and
+	 * "worst_frame". If any trial failed, "minimized_trace" holds the smallest
+	 * failing input found as an Array of {"time", "pid", "state"}.
+	 */
+	Dictionary run();
+
+	TapDifferentialTester() = default;
+};
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <atomic>
+
+#include "core/math/audio_frame.h"
+#include "core/math/math_funcs.h"
+
+/*
+Small DSP building blocks shared by the stream drivers and components. Both
+stereo channels run side by side through the same coefficients, which keeps
+the inner loops free of branches and lets the compiler pair up the lanes.
+*/
+
+/*
+Delay state for one biquad section.
+*/
+struct tap_biquad_state_t {
+	AudioFrame z1 = AudioFrame(0.0f, 0.0f);
+	AudioFrame z2 = AudioFrame(0.0f, 0.0f);
+};
+
+/*
+A biquad section in transposed direct form II, normalized so a0 = 1.
+*/
+struct tap_biquad_t {
+	float b0 = 1.0f;
+	float b1 = 0.0f;
+	float b2 = 0.0f;
+	float a1 = 0.0f;
+	float a2 = 0.0f;
+
+	/*
+	RBJ cookbook low pass. `cutoff` is a fraction of the sample rate and is
+	clamped below Nyquist.
+	*/
+	static inline tap_biquad_t low_pass(double cutoff, double q) {
+		cutoff = CLAMP(cutoff, 1e-6, 0.49);
+
+		double w0 = 2.0 * Math::PI * cutoff;
+		double cos_w0 = Math::cos(w0);
+		double alpha = Math::sin(w0) / (2.0 * q);
+		double a0 = 1.0 + alpha;
+
+		tap_biquad_t biquad;
+		biquad.b0 = (float)(((1.0 - cos_w0) * 0.5) / a0);
+		biquad.b1 = (float)((1.0 - cos_w0) / a0);
+		biquad.b2 = biquad.b0;
+		biquad.a1 = (float)((-2.0 * cos_w0) / a0);
+		biquad.a2 = (float)((1.0 - alpha) / a0);
+		return biquad;
+	}
+
+	/*
+	RBJ cookbook high pass, same conventions as `low_pass`.
+	*/
+	static inline tap_biquad_t high_pass(double cutoff, double q) {
+		cutoff = CLAMP(cutoff, 1e-6, 0.49);
+
+		double w0 = 2.0 * Math::PI * cutoff;
+		double cos_w0 = Math::cos(w0);
+		double alpha = Math::sin(w0) / (2.0 * q);
+		double a0 = 1.0 + alpha;
+
+		tap_biquad_t biquad;
+		biquad.b0 = (float)(((1.0 + cos_w0) * 0.5) / a0);
+		biquad.b1 = (float)(-(1.0 + cos_w0) / a0);
+		biquad.b2 = biquad.b0;
+		biquad.a1 = (float)((-2.0 * cos_w0) / a0);
+		biquad.a2 = (float)((1.0 - alpha) / a0);
+		return biquad;
+	}
+
+	/*
+	RBJ cookbook band pass with 0 dB peak gain, same conventions as `low_pass`.
+	*/
+	static inline tap_biquad_t band_pass(double cutoff, double q) {
+		cutoff = CLAMP(cutoff, 1e-6, 0.49);
+
+		double w0 = 2.0 * Math::PI * cutoff;
+		double cos_w0 = Math::cos(w0);
+		double alpha = Math::sin(w0) / (2.0 * q);
+		double a0 = 1.0 + alpha;
+
+		tap_biquad_t biquad;
+		biquad.b0 = (float)(alpha / a0);
+		biquad.b1 = 0.0f;
+		biquad.b2 = (float)(-alpha / a0);
+		biquad.a1 = (float)((-2.0 * cos_w0) / a0);
+		biquad.a2 = (float)((1.0 - alpha) / a0);
+		return biquad;
+	}
+
+	inline AudioFrame process(AudioFrame in, tap_biquad_state_t &state) const {
+		AudioFrame out = in * b0 + state.z1;
+		state.z1 = in * b1 - out * a1 + state.z2;
+		state.z2 = in * b2 - out * a2;
+		return out;
+	}
+
+	/*
+	Filter `frames` frames of `buffer` in place. The delay state is kept in
+	locals for the length of the block.
+	*/
+	inline void process_block(AudioFrame *buffer, int frames, tap_biquad_state_t &state) const {
+		float z1l = state.z1.left, z1r = state.z1.right;
+		float z2l = state.z2.left, z2r = state.z2.right;
+
+		for (int i = 0; i < frames; i++) {
+			float inl = buffer[i].left;
+			float inr = buffer[i].right;
+
+			float outl = inl * b0 + z1l;
+			float outr = inr * b0 + z1r;
+
+			z1l = inl * b1 - outl * a1 + z2l;
+			z1r = inr * b1 - outr * a1 + z2r;
+			z2l = inl * b2 - outl * a2;
+			z2r = inr * b2 - outr * a2;
+
+			buffer[i].left = outl;
+			buffer[i].right = outr;
+		}
+
+		state.z1 = AudioFrame(z1l, z1r);
+		state.z2 = AudioFrame(z2l, z2r);
+	}
+};
+
+/*
+4th order Butterworth low pass made from two biquad sections. Used to band
+limit an input before it gets decimated into events.
+*/
+struct tap_anti_alias_t {
+	tap_biquad_t sections[2];
+	tap_biquad_state_t states[2];
+	//the decimation factor the coefficients were designed for, 0 if unset
+	int designed_for = 0;
+
+	/*
+	Design for a decimation factor, placing the cutoff a little under the
+	decimated Nyquist. Keeps the delay state so redesigns don't click.
+	*/
+	inline void design(int decimation) {
+		double cutoff = 0.45 / (double)MAX(decimation, 1);
+		sections[0] = tap_biquad_t::low_pass(cutoff, 0.54119610);
+		sections[1] = tap_biquad_t::low_pass(cutoff, 1.30656296);
+		designed_for = decimation;
+	}
+
+	inline void process_block(AudioFrame *buffer, int frames) {
+		sections[0].process_block(buffer, frames, states[0]);
+		sections[1].process_block(buffer, frames, states[1]);
+	}
+
+	inline void reset() {
+		states[0] = tap_biquad_state_t();
+		states[1] = tap_biquad_state_t();
+	}
+};
+
+/*
+Per-channel sum, sum of squares and peak magnitude of a block.
+*/
+struct tap_block_stats_t {
+	AudioFrame sum = AudioFrame(0.0f, 0.0f);
+	AudioFrame squares = AudioFrame(0.0f, 0.0f);
+	AudioFrame peak = AudioFrame(0.0f, 0.0f);
+};
+
+/*
+Reduce a block in four independent lanes per channel so the loop has no
+carried dependency and vectorizes.
+*/
+static inline tap_block_stats_t tap_reduce_block(const AudioFrame *buffer, int frames) {
+	static constexpr int LANES = 4;
+
+	float sum_l[LANES] = {}, sum_r[LANES] = {};
+	float squares_l[LANES] = {}, squares_r[LANES] = {};
+	float peak_l[LANES] = {}, peak_r[LANES] = {};
+
+	int i = 0;
+	for (; i + LANES <= frames; i += LANES) {
+		for (int lane = 0; lane < LANES; lane++) {
+			float l = buffer[i + lane].left;
+			float r = buffer[i + lane].right;
+			sum_l[lane] += l;
+			sum_r[lane] += r;
+			squares_l[lane] += l * l;
+			squares_r[lane] += r * r;
+			peak_l[lane] = MAX(peak_l[lane], Math::abs(l));
+			peak_r[lane] = MAX(peak_r[lane], Math::abs(r));
+		}
+	}
+	for (; i < frames; i++) {
+		float l = buffer[i].left;
+		float r = buffer[i].right;
+		sum_l[0] += l;
+		sum_r[0] += r;
+		squares_l[0] += l * l;
+		squares_r[0] += r * r;
+		peak_l[0] = MAX(peak_l[0], Math::abs(l));
+		peak_r[0] = MAX(peak_r[0], Math::abs(r));
+	}
+
+	tap_block_stats_t stats;
+	for (int lane = 0; lane < LANES; lane++) {
+		stats.sum += AudioFrame(sum_l[lane], sum_r[lane]);
+		stats.squares += AudioFrame(squares_l[lane], squares_r[lane]);
+		stats.peak.left = MAX(stats.peak.left, peak_l[lane]);
+		stats.peak.right = MAX(stats.peak.right, peak_r[lane]);
+	}
+	return stats;
+}
+
+/*
+Running output statistics, written by the audio thread one block at a time and
+read from the main thread without a lock.
+
+Totals only ever grow, so readers take the difference between two snapshots to
+get a window. The frame count is stored last and loaded first, so a snapshot
+may include sums from one block past its frame count, never fewer.
+*/
+struct tap_stats_accumulator_t {
+	struct snapshot_t {
+		uint64_t frames = 0;
+		double sum[2] = {};
+		double squares[2] = {};
+	};
+
+	std::atomic<uint64_t> frames{ 0 };
+	std::atomic<double> sum[2] = {};
+	std::atomic<double> squares[2] = {};
+	std::atomic<float> peak[2] = {};
+
+	//audio thread only
+	inline void add_block(const AudioFrame *buffer, int count) {
+		tap_block_stats_t block = tap_reduce_block(buffer, count);
+
+		//single writer, so a load and a store is enough
+		sum[0].store(sum[0].load(std::memory_order_relaxed) + block.sum.left, std::memory_order_relaxed);
+		sum[1].store(sum[1].load(std::memory_order_relaxed) + block.sum.right, std::memory_order_relaxed);
+		squares[0].store(squares[0].load(std::memory_order_relaxed) + block.squares.left, std::memory_order_relaxed);
+		squares[1].store(squares[1].load(std::memory_order_relaxed) + block.squares.right, std::memory_order_relaxed);
+		raise_peak(peak[0], block.peak.left);
+		raise_peak(peak[1], block.peak.right);
+
+		frames.store(frames.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+	inline snapshot_t snapshot() const {
+		snapshot_t snap;
+		snap.frames = frames.load(std::memory_order_acquire);
+		for (int c = 0; c < 2; c++) {
+			snap.sum[c] = sum[c].load(std::memory_order_relaxed);
+			snap.squares[c] = squares[c].load(std::memory_order_relaxed);
+		}
+		return snap;
+	}
+
+	//peak since the last call
+	inline AudioFrame take_peak() {
+		return AudioFrame(peak[0].exchange(0.0f, std::memory_order_relaxed), peak[1].exchange(0.0f, std::memory_order_relaxed));
+	}
+
+	static inline void raise_peak(std::atomic<float> &target, float value) {
+		//the reader may swap in a 0, so this has to be a compare exchange
+		float current = target.load(std::memory_order_relaxed);
+		while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+		}
+	}
+};
+
+/*
+Band-limited mix of sine, triangle, square and saw, generated a block at a
+time in float.
+
+Sine reads a linearly interpolated table. Saw and square are the naive ramps
+with a polyBLEP residual subtracted at each step, which removes most of the
+aliasing the naive edges fold back. Triangle has no step but its slope jumps
+at each corner, so it gets the integrated residual, polyBLAMP, there instead.
+
+Against the naive double precision waveforms the output agrees to within 1e-5
+of the amplitude, except within one phase increment of a saw or square edge
+or a triangle corner. At an edge the polyBLEP residual rounds the step off by
+up to its full height, at a corner polyBLAMP by up to 4/3 of the phase
+increment, scaled by that waveform's weight.
+*/
+struct tap_oscillator_t {
+	static constexpr int TABLE_BITS = 11;
+	static constexpr int TABLE_SIZE = 1 << TABLE_BITS;
+	//frames generated per pass, small enough to stay in registers
+	static constexpr int BLOCK = 8;
+
+	//one period of sine plus a guard entry, so interpolation never wraps
+	static inline const float *sine_table() {
+		static const struct table_t {
+			float values[TABLE_SIZE + 1];
+			table_t() {
+				for (int i = 0; i <= TABLE_SIZE; i++) {
+					values[i] = (float)Math::sin(2.0 * Math::PI * (double)i / (double)TABLE_SIZE);
+				}
+			}
+		} table;
+		return table.values;
+	}
+
+	//negative weights mute their waveform
+	float sin_weight = 0.0f;
+	float tri_weight = 0.0f;
+	float sqr_weight = 0.0f;
+	float saw_weight = 0.0f;
+
+	inline void set_weights(float sin, float tri, float sqr, float saw) {
+		sin_weight = MAX(sin, 0.0f);
+		tri_weight = MAX(tri, 0.0f);
+		sqr_weight = MAX(sqr, 0.0f);
+		saw_weight = MAX(saw, 0.0f);
+	}
+
+	/*
+	Residual of a step of 2 at phase 0, the -1 to 1 edges of the square and saw,
+	for a phase `t` in [0, 1) advancing `dt` per frame. Zero everywhere but the
+	frame on either side of the step. Half of it is a unit step's residual.
+	*/
+	static inline float poly_blep(float t, float dt, float inverse_dt) {
+		float before = (t - 1.0f) * inverse_dt;
+		float after = t * inverse_dt;
+		float rising = after + after - after * after - 1.0f;
+		float falling = before * before + before + before + 1.0f;
+		return t < dt ? rising : (t > 1.0f - dt ? falling : 0.0f);
+	}
+
+	/*
+	Residual of a unit slope increase per frame at phase 0, the integral of a
+	unit step's polyBLEP, so half the integral of `poly_blep`. Same support.
+	*/
+	static inline float poly_blamp(float t, float dt, float inverse_dt) {
+		float before = (t - 1.0f) * inverse_dt + 1.0f;
+		float after = 1.0f - t * inverse_dt;
+		float rising = after * after * after * (1.0f / 6.0f);
+		float falling = before * before * before * (1.0f / 6.0f);
+		return t < dt ? rising : (t > 1.0f - dt ? falling : 0.0f);
+	}
+
+	/*
+	Write `frames` mono frames into both channels of `buffer`, starting at
+	`phase` in periods. The phase increment moves linearly from `increment` to
+	`end_increment` and the gain from `gain` to `end_gain` across the call, so
+	parameter changes ramp per frame instead of stepping. `phase` is kept in
+	double between blocks so long runs don't drift.
+	*/
+	inline void generate(AudioFrame *buffer, int frames, double &phase, double increment, double end_increment, float gain, float end_gain) const {
+		if (frames <= 0) {
+			return;
+		}
+
+		const float *table = sine_table();
+		double increment_step = (end_increment - increment) / (double)frames;
+		float gain_step = (end_gain - gain) / (float)frames;
+		//the polyBLEP width follows the faster end of the ramp
+		float dt = CLAMP((float)MAX(Math::abs(increment), Math::abs(end_increment)), 1e-7f, 0.5f);
+		float inverse_dt = 1.0f / dt;
+		//running backwards turns every step over
+		float direction = increment + end_increment < 0.0 ? -1.0f : 1.0f;
+
+		phase -= Math::floor(phase);
+
+		for (int done = 0; done < frames; done += BLOCK) {
+			int count = MIN(BLOCK, frames - done);
+			float rate = (float)increment;
+			float acceleration = (float)increment_step;
+			float block_gain = gain + gain_step * (float)done;
+
+			float t[BLOCK];
+			float sample[BLOCK];
+			float base = (float)phase;
+			for (int i = 0; i < BLOCK; i++) {
+				float p = base + rate * (float)i + acceleration * (float)(i * (i - 1) / 2);
+				p -= (float)(int)p;
+				t[i] = p < 0.0f ? p + 1.0f : p;
+				sample[i] = 0.0f;
+			}
+
+			//one branch per waveform per block, not per frame
+			if (sin_weight != 0.0f) {
+				for (int i = 0; i < BLOCK; i++) {
+					float position = t[i] * (float)TABLE_SIZE;
+					int index = (int)position;
+					float fraction = position - (float)index;
+					//t can round up to exactly 1, which is the same point as 0
+					index &= TABLE_SIZE - 1;
+					float a = table[index];
+					sample[i] += sin_weight * (a + fraction * (table[index + 1] - a));
+				}
+			}
+			if (tri_weight != 0.0f) {
+				//the slope turns by 8 per period, up at 0 and down at 0.5. Both
+				//corners look the same running backwards
+				float corner = 8.0f * dt;
+				for (int i = 0; i < BLOCK; i++) {
+					float half = t[i] < 0.5f ? t[i] + 0.5f : t[i] - 0.5f;
+					float naive = 1.0f - 4.0f * Math::abs(t[i] - 0.5f);
+					sample[i] += tri_weight * (naive + corner * (poly_blamp(t[i], dt, inverse_dt) - poly_blamp(half, dt, inverse_dt)));
+				}
+			}
+			if (sqr_weight != 0.0f) {
+				for (int i = 0; i < BLOCK; i++) {
+					float half = t[i] < 0.5f ? t[i] + 0.5f : t[i] - 0.5f;
+					float naive = t[i] < 0.5f ? 1.0f : -1.0f;
+					sample[i] += sqr_weight * (naive + direction * (poly_blep(t[i], dt, inverse_dt) - poly_blep(half, dt, inverse_dt)));
+				}
+			}
+			if (saw_weight != 0.0f) {
+				for (int i = 0; i < BLOCK; i++) {
+					sample[i] += saw_weight * (2.0f * t[i] - 1.0f - direction * poly_blep(t[i], dt, inverse_dt));
+				}
+			}
+
+			for (int i = 0; i < count; i++) {
+				float out = sample[i] * (block_gain + gain_step * (float)i);
+				buffer[done + i] = AudioFrame(out, out);
+			}
+
+			phase += increment * (double)count + increment_step * (double)(count * (count - 1) / 2);
+			phase -= Math::floor(phase);
+			increment += increment_step * (double)count;
+		}
+	}
+};
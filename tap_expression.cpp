@@ -0,0 +1,636 @@
+#include <cstring>
+
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+
+#include "tap_expression.h"
+
+namespace {
+
+enum token_kind_t {
+	TOKEN_END,
+	TOKEN_SEPARATOR,
+	TOKEN_NUMBER,
+	TOKEN_NAME,
+	TOKEN_SYMBOL,
+};
+
+struct token_t {
+	token_kind_t kind = TOKEN_END;
+	String text;
+	float value = 0.0f;
+	int line = 1;
+	int column = 1;
+};
+
+//expression graph node. Inputs and constants are leaves, everything else an opcode
+struct node_t {
+	static constexpr int INPUT = -1;
+	static constexpr int CONSTANT = -2;
+
+	int op = CONSTANT;
+	int a = -1;
+	int b = -1;
+	int c = -1;
+	float value = 0.0f;
+};
+
+struct function_t {
+	const char *name;
+	int op;
+	int arguments;
+};
+
+static bool is_name_start(char32_t c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool is_digit(char32_t c) {
+	return c >= '0' && c <= '9';
+}
+
+/*
+Recursive descent over the token stream, building a deduplicated graph of
+nodes. Constant folding happens as each node is made.
+*/
+struct compiler_t {
+	LocalVector<token_t> tokens;
+	uint32_t position = 0;
+	String error;
+
+	LocalVector<node_t> nodes;
+	HashMap<String, int> locals;
+	//graph node driving each output, -1 if never assigned
+	LocalVector<int> outputs;
+	int input_count = 0;
+
+	//deep nesting fails to parse rather than running out of stack
+	static constexpr int MAX_DEPTH = 256;
+	int depth = 0;
+
+	bool fail(const token_t &at, const String &message) {
+		if (error.is_empty()) {
+			error = vformat("line %d, column %d: %s", at.line, at.column, message);
+		}
+		return false;
+	}
+
+	bool enter(const token_t &at) {
+		if (depth >= MAX_DEPTH) {
+			return fail(at, vformat("nested more than %d deep.", MAX_DEPTH));
+		}
+		depth++;
+		return true;
+	}
+
+	bool tokenize(const String &source) {
+		int line = 1;
+		int line_start = 0;
+		int length = source.length();
+		int i = 0;
+
+		while (i < length) {
+			char32_t c = source[i];
+			token_t token;
+			token.line = line;
+			token.column = i - line_start + 1;
+
+			if (c == '#') {
+				while (i < length && source[i] != '\n') {
+					i++;
+				}
+				continue;
+			}
+			if (c == '\n' || c == ';') {
+				token.kind = TOKEN_SEPARATOR;
+				tokens.push_back(token);
+				if (c == '\n') {
+					line++;
+					line_start = i + 1;
+				}
+				i++;
+				continue;
+			}
+			if (c == ' ' || c == '\t' || c == '\r') {
+				i++;
+				continue;
+			}
+
+			if (is_digit(c) || (c == '.' && i + 1 < length && is_digit(source[i + 1]))) {
+				int start = i;
+				while (i < length && (is_digit(source[i]) || source[i] == '.')) {
+					i++;
+				}
+				if (i < length && (source[i] == 'e' || source[i] == 'E')) {
+					i++;
+					if (i < length && (source[i] == '+' || source[i] == '-')) {
+						i++;
+					}
+					while (i < length && is_digit(source[i])) {
+						i++;
+					}
+				}
+				token.kind = TOKEN_NUMBER;
+				token.text = source.substr(start, i - start);
+				if (!token.text.is_valid_float()) {
+					return fail(token, "malformed number \"" + token.text + "\".");
+				}
+				token.value = (float)token.text.to_float();
+				tokens.push_back(token);
+				continue;
+			}
+
+			if (is_name_start(c)) {
+				int start = i;
+				while (i < length && (is_name_start(source[i]) || is_digit(source[i]))) {
+					i++;
+				}
+				token.kind = TOKEN_NAME;
+				token.text = source.substr(start, i - start);
+				tokens.push_back(token);
+				continue;
+			}
+
+			static const char *const pairs[] = { "<=", ">=", "==", "!=", "&&", "||" };
+			token.kind = TOKEN_SYMBOL;
+			for (const char *pair : pairs) {
+				if (i + 1 < length && c == (char32_t)pair[0] && source[i + 1] == (char32_t)pair[1]) {
+					token.text = pair;
+					break;
+				}
+			}
+			if (token.text.is_empty()) {
+				if (String("+-*/()<>=!?:,").find(String::chr(c)) < 0) {
+					return fail(token, "unexpected character '" + String::chr(c) + "'.");
+				}
+				token.text = String::chr(c);
+			}
+			i += token.text.length();
+			tokens.push_back(token);
+		}
+
+		token_t end;
+		end.line = line;
+		end.column = length - line_start + 1;
+		tokens.push_back(end);
+		return true;
+	}
+
+	const token_t &peek() const {
+		return tokens[position];
+	}
+
+	bool accept(const char *symbol) {
+		if (peek().kind == TOKEN_SYMBOL && peek().text == symbol) {
+			position++;
+			return true;
+		}
+		return false;
+	}
+
+	bool expect(const char *symbol) {
+		if (accept(symbol)) {
+			return true;
+		}
+		return fail(peek(), vformat("expected '%s'.", symbol));
+	}
+
+	int constant(float value) {
+		for (uint32_t i = 0; i < nodes.size(); i++) {
+			if (nodes[i].op == node_t::CONSTANT && memcmp(&nodes[i].value, &value, sizeof(float)) == 0) {
+				return i;
+			}
+		}
+		node_t node;
+		node.value = value;
+		nodes.push_back(node);
+		return nodes.size() - 1;
+	}
+
+	bool is_constant(int node, float value) const {
+		return nodes[node].op == node_t::CONSTANT && nodes[node].value == value;
+	}
+
+	int make(int op, int a, int b = -1, int c = -1) {
+		if (a < 0 || (b < 0 && b != -1) || (c < 0 && c != -1)) {
+			return -2;
+		}
+
+		bool folds = nodes[a].op == node_t::CONSTANT && (b == -1 || nodes[b].op == node_t::CONSTANT) && (c == -1 || nodes[c].op == node_t::CONSTANT);
+		if (folds) {
+			float vb = b == -1 ? 0.0f : nodes[b].value;
+			float vc = c == -1 ? 0.0f : nodes[c].value;
+			return constant(tap_expression_t::apply(op, nodes[a].value, vb, vc));
+		}
+
+		//identities that hold for every finite input
+		if ((op == tap_expression_t::OP_ADD || op == tap_expression_t::OP_SUB) && is_constant(b, 0.0f)) {
+			return a;
+		}
+		if (op == tap_expression_t::OP_ADD && is_constant(a, 0.0f)) {
+			return b;
+		}
+		if ((op == tap_expression_t::OP_MUL || op == tap_expression_t::OP_DIV) && is_constant(b, 1.0f)) {
+			return a;
+		}
+		if (op == tap_expression_t::OP_MUL && is_constant(a, 1.0f)) {
+			return b;
+		}
+		if (op == tap_expression_t::OP_SELECT && nodes[a].op == node_t::CONSTANT) {
+			return tap_expression_t::truth(nodes[a].value) ? b : c;
+		}
+
+		//share repeated subexpressions
+		for (uint32_t i = 0; i < nodes.size(); i++) {
+			const node_t &node = nodes[i];
+			if (node.op == op && node.a == a && node.b == b && node.c == c) {
+				return i;
+			}
+		}
+
+		node_t node;
+		node.op = op;
+		node.a = a;
+		node.b = b;
+		node.c = c;
+		nodes.push_back(node);
+		return nodes.size() - 1;
+	}
+
+	//parse functions return a node index, or -2 once an error is set
+	int parse_expression() {
+		if (!enter(peek())) {
+			return -2;
+		}
+		int result = parse_conditional();
+		depth--;
+		return result;
+	}
+
+	int parse_conditional() {
+		int condition = parse_binary(0);
+		if (condition < 0 || !accept("?")) {
+			return condition;
+		}
+		int then_node = parse_expression();
+		if (then_node < 0 || !expect(":")) {
+			return -2;
+		}
+		int else_node = parse_expression();
+		return make(tap_expression_t::OP_SELECT, condition, then_node, else_node);
+	}
+
+	//binary operators by precedence level, loosest first
+	int parse_binary(int level) {
+		static const char *const symbols[][6] = {
+			{ "||" },
+			{ "&&" },
+			{ "<", "<=", ">", ">=", "==", "!=" },
+			{ "+", "-" },
+			{ "*", "/" },
+		};
+		static const int ops[][6] = {
+			{ tap_expression_t::OP_OR },
+			{ tap_expression_t::OP_AND },
+			{ tap_expression_t::OP_LESS, tap_expression_t::OP_LESS_EQUAL, tap_expression_t::OP_GREATER, tap_expression_t::OP_GREATER_EQUAL, tap_expression_t::OP_EQUAL, tap_expression_t::OP_NOT_EQUAL },
+			{ tap_expression_t::OP_ADD, tap_expression_t::OP_SUB },
+			{ tap_expression_t::OP_MUL, tap_expression_t::OP_DIV },
+		};
+		constexpr int levels = sizeof(ops) / sizeof(ops[0]);
+
+		if (level == levels) {
+			return parse_unary();
+		}
+
+		int left = parse_binary(level + 1);
+		while (left >= 0) {
+			int op = -1;
+			for (int i = 0; i < 6 && symbols[level][i] != nullptr; i++) {
+				if (accept(symbols[level][i])) {
+					op = ops[level][i];
+					break;
+				}
+			}
+			if (op < 0) {
+				break;
+			}
+			left = make(op, left, parse_binary(level + 1));
+		}
+		return left;
+	}
+
+	int parse_unary() {
+		if (!enter(peek())) {
+			return -2;
+		}
+		int result;
+		if (accept("-")) {
+			result = make(tap_expression_t::OP_NEG, parse_unary());
+		} else if (accept("!")) {
+			result = make(tap_expression_t::OP_NOT, parse_unary());
+		} else if (accept("+")) {
+			result = parse_unary();
+		} else {
+			result = parse_primary();
+		}
+		depth--;
+		return result;
+	}
+
+	int parse_call(const token_t &name) {
+		static const function_t functions[] = {
+			{ "min", tap_expression_t::OP_MIN, 2 },
+			{ "max", tap_expression_t::OP_MAX, 2 },
+			{ "abs", tap_expression_t::OP_ABS, 1 },
+			{ "floor", tap_expression_t::OP_FLOOR, 1 },
+			{ "sqrt", tap_expression_t::OP_SQRT, 1 },
+			{ "sin", tap_expression_t::OP_SIN, 1 },
+			{ "cos", tap_expression_t::OP_COS, 1 },
+			{ "tanh", tap_expression_t::OP_TANH, 1 },
+			{ "select", tap_expression_t::OP_SELECT, 3 },
+			{ "clamp", tap_expression_t::OP_CLAMP, 3 },
+			//not an opcode of its own, expanded below
+			{ "lerp", -1, 3 },
+		};
+
+		const function_t *function = nullptr;
+		for (const function_t &candidate : functions) {
+			if (name.text == candidate.name) {
+				function = &candidate;
+				break;
+			}
+		}
+		if (function == nullptr) {
+			fail(name, "unknown function \"" + name.text + "\".");
+			return -2;
+		}
+
+		int arguments[3] = { -1, -1, -1 };
+		int count = 0;
+		if (!accept(")")) {
+			do {
+				if (count == 3) {
+					fail(name, "too many arguments to \"" + name.text + "\".");
+					return -2;
+				}
+				arguments[count] = parse_expression();
+				if (arguments[count] < 0) {
+					return -2;
+				}
+				count++;
+			} while (accept(","));
+			if (!expect(")")) {
+				return -2;
+			}
+		}
+
+		//clamp(x) limits to the range a tap_frame channel can hold
+		if (function->op == tap_expression_t::OP_CLAMP && count == 1) {
+			return make(tap_expression_t::OP_CLAMP, arguments[0], constant(-1.0f), constant(1.0f));
+		}
+		if (count != function->arguments) {
+			fail(name, vformat("\"%s\" takes %d arguments, got %d.", name.text, function->arguments, count));
+			return -2;
+		}
+		if (function->op == -1) {
+			//lerp(a, b, t) = a + (b - a) * t
+			int span = make(tap_expression_t::OP_SUB, arguments[1], arguments[0]);
+			return make(tap_expression_t::OP_ADD, arguments[0], make(tap_expression_t::OP_MUL, span, arguments[2]));
+		}
+		return make(function->op, arguments[0], arguments[1], arguments[2]);
+	}
+
+	//`prefix` followed by a pin number, such as in3
+	static int pin_index(const String &name, const String &prefix) {
+		if (!name.begins_with(prefix) || name.length() == prefix.length()) {
+			return -1;
+		}
+		String digits = name.substr(prefix.length());
+		if (!digits.is_valid_int() || (digits.length() > 1 && digits[0] == '0')) {
+			return -1;
+		}
+		int64_t index = digits.to_int();
+		return index < tap_expression_t::MAX_PINS ? (int)index : -1;
+	}
+
+	int parse_primary() {
+		token_t token = peek();
+
+		if (token.kind == TOKEN_NUMBER) {
+			position++;
+			return constant(token.value);
+		}
+
+		if (token.kind == TOKEN_NAME) {
+			position++;
+			if (accept("(")) {
+				return parse_call(token);
+			}
+
+			const int *local = locals.getptr(token.text);
+			if (local != nullptr) {
+				return *local;
+			}
+			if (token.text == "pi") {
+				return constant((float)Math::PI);
+			}
+
+			int input = pin_index(token.text, "in");
+			if (input >= 0) {
+				input_count = MAX(input_count, input + 1);
+				for (uint32_t i = 0; i < nodes.size(); i++) {
+					if (nodes[i].op == node_t::INPUT && (int)nodes[i].value == input) {
+						return i;
+					}
+				}
+				node_t node;
+				node.op = node_t::INPUT;
+				node.value = (float)input;
+				nodes.push_back(node);
+				return nodes.size() - 1;
+			}
+
+			fail(token, "\"" + token.text + "\" is not an input, function or assigned name.");
+			return -2;
+		}
+
+		if (accept("(")) {
+			int inner = parse_expression();
+			if (inner < 0 || !expect(")")) {
+				return -2;
+			}
+			return inner;
+		}
+
+		fail(token, token.kind == TOKEN_END || token.kind == TOKEN_SEPARATOR ? String("expected a value.") : "unexpected \"" + token.text + "\".");
+		return -2;
+	}
+
+	bool parse_statement() {
+		token_t name = peek();
+		if (name.kind != TOKEN_NAME) {
+			return fail(name, "expected an assignment, such as out0 = in0.");
+		}
+		position++;
+		if (!expect("=")) {
+			return false;
+		}
+
+		int value = parse_expression();
+		if (value < 0) {
+			return false;
+		}
+		if (peek().kind != TOKEN_SEPARATOR && peek().kind != TOKEN_END) {
+			return fail(peek(), "expected the end of the statement.");
+		}
+
+		if (pin_index(name.text, "in") >= 0) {
+			return fail(name, "inputs can't be assigned.");
+		}
+		int output = pin_index(name.text, "out");
+		if (output >= 0) {
+			while ((int)outputs.size() <= output) {
+				outputs.push_back(-1);
+			}
+			//a later assignment replaces the earlier one, which is then dead
+			outputs[output] = value;
+		}
+		locals[name.text] = value;
+		return true;
+	}
+
+	bool parse_program() {
+		while (peek().kind != TOKEN_END) {
+			if (peek().kind == TOKEN_SEPARATOR) {
+				position++;
+				continue;
+			}
+			if (!parse_statement()) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+/*
+Lays out the nodes reachable from the outputs as registers and instructions.
+Whatever no output reaches is never emitted.
+*/
+struct emitter_t {
+	const compiler_t &compiler;
+	//register per node, -1 until placed
+	LocalVector<int> registers;
+	LocalVector<float> constants;
+	LocalVector<int> constant_nodes;
+	LocalVector<int> instruction_nodes;
+
+	explicit emitter_t(const compiler_t &p_compiler) :
+			compiler(p_compiler) {
+		registers.resize(compiler.nodes.size());
+		for (int &r : registers) {
+			r = -1;
+		}
+	}
+
+	//depth first, so operands are collected before the node using them
+	void collect(int node) {
+		if (node < 0 || registers[node] != -1) {
+			return;
+		}
+		//mark as visited, the real register is set in assign
+		registers[node] = -2;
+
+		const node_t &n = compiler.nodes[node];
+		if (n.op == node_t::CONSTANT) {
+			constant_nodes.push_back(node);
+			return;
+		}
+		if (n.op == node_t::INPUT) {
+			return;
+		}
+		collect(n.a);
+		collect(n.b);
+		collect(n.c);
+		instruction_nodes.push_back(node);
+	}
+
+	void assign(int input_count) {
+		for (uint32_t i = 0; i < compiler.nodes.size(); i++) {
+			if (compiler.nodes[i].op == node_t::INPUT && registers[i] != -1) {
+				registers[i] = (int)compiler.nodes[i].value;
+			}
+		}
+		for (uint32_t i = 0; i < constant_nodes.size(); i++) {
+			registers[constant_nodes[i]] = input_count + i;
+			constants.push_back(compiler.nodes[constant_nodes[i]].value);
+		}
+		int first_result = input_count + constants.size();
+		for (uint32_t i = 0; i < instruction_nodes.size(); i++) {
+			registers[instruction_nodes[i]] = first_result + i;
+		}
+	}
+
+	float operand(int node) const {
+		return node < 0 ? 0.0f : (float)registers[node];
+	}
+};
+
+} //namespace
+
+Error tap_expression_t::compile(const String &source, Vector<float> &r_program, String &r_error) {
+	compiler_t compiler;
+	if (!compiler.tokenize(source) || !compiler.parse_program()) {
+		r_error = compiler.error;
+		return ERR_PARSE_ERROR;
+	}
+
+	bool any_output = false;
+	for (int output : compiler.outputs) {
+		any_output = any_output || output >= 0;
+	}
+	if (!any_output) {
+		r_error = "nothing is assigned to an output, such as out0.";
+		return ERR_PARSE_ERROR;
+	}
+	if (compiler.input_count == 0) {
+		r_error = "no input is read, so the component would never run.";
+		return ERR_PARSE_ERROR;
+	}
+
+	emitter_t emitter(compiler);
+	for (int output : compiler.outputs) {
+		emitter.collect(output);
+	}
+	emitter.assign(compiler.input_count);
+
+	int register_count = compiler.input_count + emitter.constants.size() + emitter.instruction_nodes.size();
+	if (register_count > MAX_REGISTERS) {
+		r_error = vformat("expression needs %d registers, more than the %d available.", register_count, MAX_REGISTERS);
+		return ERR_OUT_OF_MEMORY;
+	}
+
+	Vector<float> program;
+	program.push_back((float)compiler.input_count);
+	program.push_back((float)compiler.outputs.size());
+	program.push_back((float)register_count);
+	program.push_back((float)emitter.constants.size());
+	program.push_back((float)emitter.instruction_nodes.size());
+
+	for (float value : emitter.constants) {
+		program.push_back(value);
+	}
+	for (int node : emitter.instruction_nodes) {
+		const node_t &n = compiler.nodes[node];
+		program.push_back((float)n.op);
+		program.push_back(emitter.operand(n.a));
+		program.push_back(emitter.operand(n.b));
+		program.push_back(emitter.operand(n.c));
+	}
+	for (int output : compiler.outputs) {
+		program.push_back(output < 0 ? -1.0f : (float)emitter.registers[output]);
+	}
+
+	r_program = program;
+	return OK;
+}
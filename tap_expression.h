@@ -0,0 +1,211 @@
+#pragma once
+
+#include "core/error/error_list.h"
+#include "core/math/math_funcs.h"
+#include "core/string/ustring.h"
+#include "core/templates/vector.h"
+
+/*
+Compiler and interpreter for component behavior written as an expression, so
+new component types don't need a solver built into the engine:
+
+	out0 = clamp(in0 + in1)
+
+	sum = in0 + in1
+	out0 = sum > 0.5
+	out1 = sum * 0.5 # comments run to the end of the line
+
+Statements are separated by newlines or `;`. `inN` reads input pin N, `outN`
+drives output pin N, and any other name is a local. Each channel is evaluated
+on its own. Operators, loosest first:
+
+	c ? a : b    ||    &&    < <= > >= == !=    + -    * /    unary - + !
+
+Functions: min, max, clamp(x) to the tap_frame range -1 to 1, clamp(x, lo, hi),
+abs, floor, sqrt, sin, cos, tanh, select(c, a, b) and lerp(a, b, t). Logic
+treats anything above 0.5 as true and gives 1 or 0. Division by zero gives 0.
+Parentheses, calls and unary operators nest at most 256 deep, past which the
+source fails to compile.
+
+Compiling happens on the main thread, once per change of the source. It folds
+constant subexpressions, shares repeated ones, and only keeps the work that
+reaches an output, so unused locals and overwritten assignments cost nothing.
+
+The compiled program is a flat float array, stored in the component type's
+parameters so it copies with the type:
+
+	inputs, outputs, register count, constant count, instruction count,
+	constants...,
+	instructions as op, a, b, c...,
+	output registers, -1 for outputs never assigned
+
+Registers hold the inputs first, then the constants, then one result per
+instruction in order. Operands are masked into the register file, so a
+hand-edited program can give wrong results but never reads out of bounds.
+*/
+struct tap_expression_t {
+	enum opcode_t {
+		OP_ADD,
+		OP_SUB,
+		OP_MUL,
+		OP_DIV,
+		OP_NEG,
+		OP_LESS,
+		OP_LESS_EQUAL,
+		OP_GREATER,
+		OP_GREATER_EQUAL,
+		OP_EQUAL,
+		OP_NOT_EQUAL,
+		OP_AND,
+		OP_OR,
+		OP_NOT,
+		OP_MIN,
+		OP_MAX,
+		OP_CLAMP,
+		OP_SELECT,
+		OP_ABS,
+		OP_FLOOR,
+		OP_SQRT,
+		OP_SIN,
+		OP_COS,
+		OP_TANH,
+		OP_MAX_OPCODE,
+	};
+
+	static constexpr int HEADER_SIZE = 5;
+	static constexpr int INSTRUCTION_SIZE = 4;
+	//a power of two, so operands can be masked into range
+	static constexpr int MAX_REGISTERS = 256;
+	static constexpr int MAX_PINS = 64;
+	//anything above this reads as logic high
+	static constexpr float LOGIC_THRESHOLD = 0.5f;
+
+	static inline bool truth(float value) {
+		return value > LOGIC_THRESHOLD;
+	}
+
+	/*
+	One operation on one channel. The compiler folds constants through this
+	same function, so folded and interpreted results always agree.
+	*/
+	static inline float apply(int op, float a, float b, float c) {
+		switch (op) {
+			case OP_ADD:
+				return a + b;
+			case OP_SUB:
+				return a - b;
+			case OP_MUL:
+				return a * b;
+			case OP_DIV:
+				return b != 0.0f ? a / b : 0.0f;
+			case OP_NEG:
+				return -a;
+			case OP_LESS:
+				return a < b ? 1.0f : 0.0f;
+			case OP_LESS_EQUAL:
+				return a <= b ? 1.0f : 0.0f;
+			case OP_GREATER:
+				return a > b ? 1.0f : 0.0f;
+			case OP_GREATER_EQUAL:
+				return a >= b ? 1.0f : 0.0f;
+			case OP_EQUAL:
+				return a == b ? 1.0f : 0.0f;
+			case OP_NOT_EQUAL:
+				return a != b ? 1.0f : 0.0f;
+			case OP_AND:
+				return truth(a) && truth(b) ? 1.0f : 0.0f;
+			case OP_OR:
+				return truth(a) || truth(b) ? 1.0f : 0.0f;
+			case OP_NOT:
+				return truth(a) ? 0.0f : 1.0f;
+			case OP_MIN:
+				return MIN(a, b);
+			case OP_MAX:
+				return MAX(a, b);
+			case OP_CLAMP:
+				return CLAMP(a, b, c);
+			case OP_SELECT:
+				return truth(a) ? b : c;
+			case OP_ABS:
+				return Math::abs(a);
+			case OP_FLOOR:
+				return Math::floor(a);
+			case OP_SQRT:
+				return a > 0.0f ? Math::sqrt(a) : 0.0f;
+			case OP_SIN:
+				return Math::sin(a);
+			case OP_COS:
+				return Math::cos(a);
+			case OP_TANH:
+				return Math::tanh(a);
+			default:
+				return 0.0f;
+		}
+	}
+
+	/*
+	Compile `source` into `r_program`. On failure `r_error` says where and why,
+	and `r_program` is left alone.
+	*/
+	static Error compile(const String &source, Vector<float> &r_program, String &r_error);
+
+	static inline int get_input_count(const float *program) {
+		return (int)program[0];
+	}
+
+	static inline int get_output_count(const float *program) {
+		return (int)program[1];
+	}
+
+	/*
+	Checks the header agrees with the program's size, in constant time. Enough
+	for `run` to stay in bounds.
+	*/
+	static inline bool is_valid(const float *program, int size) {
+		if (size < HEADER_SIZE) {
+			return false;
+		}
+		int inputs = (int)program[0];
+		int outputs = (int)program[1];
+		int registers = (int)program[2];
+		int constants = (int)program[3];
+		int instructions = (int)program[4];
+		if (inputs < 0 || outputs < 0 || constants < 0 || instructions < 0 || inputs > MAX_PINS || outputs > MAX_PINS) {
+			return false;
+		}
+		if (registers != inputs + constants + instructions || registers > MAX_REGISTERS) {
+			return false;
+		}
+		return size == HEADER_SIZE + constants + instructions * INSTRUCTION_SIZE + outputs;
+	}
+
+	/*
+	Run a valid program over both channels. The first `inputs` registers of
+	`left` and `right` must already hold the inputs. Returns the output
+	registers, one per output, -1 where the output is never driven.
+	*/
+	static inline const float *run(const float *program, float *left, float *right) {
+		int inputs = (int)program[0];
+		int constants = (int)program[3];
+		int instructions = (int)program[4];
+
+		const float *constant = program + HEADER_SIZE;
+		for (int i = 0; i < constants; i++) {
+			left[inputs + i] = constant[i];
+			right[inputs + i] = constant[i];
+		}
+
+		const float *code = constant + constants;
+		int destination = inputs + constants;
+		for (int i = 0; i < instructions; i++, code += INSTRUCTION_SIZE, destination++) {
+			int op = (int)code[0];
+			int a = (int)code[1] & (MAX_REGISTERS - 1);
+			int b = (int)code[2] & (MAX_REGISTERS - 1);
+			int c = (int)code[3] & (MAX_REGISTERS - 1);
+			left[destination] = apply(op, left[a], left[b], left[c]);
+			right[destination] = apply(op, right[a], right[b], right[c]);
+		}
+
+		return code;
+	}
+};
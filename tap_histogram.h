@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "core/math/math_funcs.h"
+#include "core/variant/dictionary.h"
+
+/*
+Lock-free latency histogram with HDR-style log buckets: every power of two is
+split into 8 linear sub-buckets, so any recorded value lands in a bucket within
+12.5% of it. Values are plain integers, nanoseconds for the mix stages.
+
+One thread records and any thread reads. Counts are relaxed atomics, so a read
+racing a write may be off by the sample in flight, never torn.
+*/
+struct tap_histogram_t {
+	static constexpr int SUB_BUCKET_BITS = 3;
+	static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	//covers values up to 2^40, about 18 minutes in nanoseconds
+	static constexpr int MAX_EXPONENT = 40;
+	static constexpr int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+	std::atomic<uint64_t> buckets[BUCKET_COUNT] = {};
+	std::atomic<uint64_t> count{ 0 };
+	std::atomic<uint64_t> sum{ 0 };
+	std::atomic<uint64_t> max{ 0 };
+
+	static inline uint64_t now_nsec() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static inline int bucket_of(uint64_t value) {
+		if (value < SUB_BUCKETS) {
+			return (int)value;
+		}
+
+		int exponent = 0;
+		for (uint64_t shifted = value >> 1; shifted != 0; shifted >>= 1) {
+			exponent++;
+		}
+		if (exponent > MAX_EXPONENT) {
+			return BUCKET_COUNT - 1;
+		}
+
+		int sub_bucket = (int)(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+		return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+	}
+
+	static inline uint64_t bucket_lower_bound(int bucket) {
+		if (bucket < SUB_BUCKETS) {
+			return (uint64_t)bucket;
+		}
+
+		int exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+		uint64_t sub_bucket = (uint64_t)(bucket % SUB_BUCKETS);
+		return (SUB_BUCKETS + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+	}
+
+	inline void record(uint64_t value) {
+		buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+
+		uint64_t current = max.load(std::memory_order_relaxed);
+		while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+		}
+	}
+
+	/*
+	The value at or below which `fraction` of the samples fall, reported as the
+	top of its bucket so it never understates a tail.
+	*/
+	inline uint64_t percentile(double fraction) const {
+		uint64_t total = count.load(std::memory_order_relaxed);
+		if (total == 0) {
+			return 0;
+		}
+
+		uint64_t target = (uint64_t)Math::ceil(fraction * (double)total);
+		target = CLAMP(target, (uint64_t)1, total);
+
+		uint64_t seen = 0;
+		for (int i = 0; i < BUCKET_COUNT; i++) {
+			seen += buckets[i].load(std::memory_order_relaxed);
+			if (seen >= target) {
+				uint64_t upper = i + 1 < BUCKET_COUNT ? bucket_lower_bound(i + 1) - 1 : bucket_lower_bound(i);
+				return MIN(upper, max.load(std::memory_order_relaxed));
+			}
+		}
+		return max.load(std::memory_order_relaxed);
+	}
+
+	inline void reset() {
+		for (int i = 0; i < BUCKET_COUNT; i++) {
+			buckets[i].store(0, std::memory_order_relaxed);
+		}
+		count.store(0, std::memory_order_relaxed);
+		sum.store(0, std::memory_order_relaxed);
+		max.store(0, std::memory_order_relaxed);
+	}
+
+	/*
+	Summarize as a Dictionary, dividing every value by `scale` (1000 turns
+	nanoseconds into microseconds).
+	*/
+	inline Dictionary to_dictionary(double scale) const {
+		uint64_t total = count.load(std::memory_order_relaxed);
+
+		Dictionary dict;
+		dict["count"] = (int64_t)total;
+		dict["mean"] = total > 0 ? (double)sum.load(std::memory_order_relaxed) / (double)total / scale : 0.0;
+		dict["p50"] = (double)percentile(0.5) / scale;
+		dict["p90"] = (double)percentile(0.9) / scale;
+		dict["p99"] = (double)percentile(0.99) / scale;
+		dict["p999"] = (double)percentile(0.999) / scale;
+		dict["max"] = (double)max.load(std::memory_order_relaxed) / scale;
+		return dict;
+	}
+};
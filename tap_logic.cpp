@@ -0,0 +1,147 @@
+#include "core/templates/local_vector.h"
+
+#include "tap_logic.h"
+
+Error tap_logic_t::compile(int inputs, const Vector<int> &gates, const Vector<int> &outputs, bool four_state, Vector<float> &r_program, String &r_error) {
+	if (inputs < 1 || outputs.is_empty()) {
+		r_error = "a logic block needs at least one input and one output.";
+		return ERR_INVALID_PARAMETER;
+	}
+	if (gates.size() % GATE_SIZE != 0) {
+		r_error = vformat("gates come in groups of %d: op, a, b, c.", GATE_SIZE);
+		return ERR_INVALID_PARAMETER;
+	}
+
+	int gate_count = gates.size() / GATE_SIZE;
+	int net_count = inputs + gate_count;
+	const int *gate = gates.ptr();
+
+	for (int g = 0; g < gate_count; g++) {
+		int op = gate[g * GATE_SIZE];
+		if (op < 0 || op >= OP_MAX_OPCODE) {
+			r_error = vformat("gate %d has unknown op %d.", g, op);
+			return ERR_INVALID_PARAMETER;
+		}
+		for (int o = 0; o < operand_count(op); o++) {
+			int net = gate[g * GATE_SIZE + 1 + o];
+			if (net < 0 || net >= net_count) {
+				r_error = vformat("gate %d reads net %d, but there are only %d.", g, net, net_count);
+				return ERR_INVALID_PARAMETER;
+			}
+		}
+	}
+	for (int o = 0; o < outputs.size(); o++) {
+		if (outputs[o] < 0 || outputs[o] >= net_count) {
+			r_error = vformat("output %d reads net %d, but there are only %d.", o, outputs[o], net_count);
+			return ERR_INVALID_PARAMETER;
+		}
+	}
+
+	//depth first from the outputs, so only live gates get an order. 1 is on the
+	//stack, 2 is placed
+	LocalVector<uint8_t> mark;
+	mark.resize(gate_count);
+	for (uint8_t &m : mark) {
+		m = 0;
+	}
+	LocalVector<int> level;
+	level.resize(gate_count);
+	LocalVector<int> order;
+
+	struct frame_t {
+		int gate;
+		int operand;
+	};
+	LocalVector<frame_t> stack;
+
+	for (int o = 0; o < outputs.size(); o++) {
+		int root = outputs[o] - inputs;
+		if (root < 0 || mark[root] == 2) {
+			continue;
+		}
+
+		mark[root] = 1;
+		stack.push_back(frame_t{ root, 0 });
+		while (!stack.is_empty()) {
+			frame_t &top = stack[stack.size() - 1];
+			int g = top.gate;
+			int op = gate[g * GATE_SIZE];
+
+			if (top.operand < operand_count(op)) {
+				int operand = gate[g * GATE_SIZE + 1 + top.operand] - inputs;
+				top.operand++;
+				if (operand < 0 || mark[operand] == 2) {
+					continue;
+				}
+				if (mark[operand] == 1) {
+					r_error = vformat("gate %d is part of a combinational loop.", operand);
+					return ERR_CYCLIC_LINK;
+				}
+				mark[operand] = 1;
+				stack.push_back(frame_t{ operand, 0 });
+				continue;
+			}
+
+			//every operand is placed, so this gate sits one level above the deepest
+			int gate_level = 0;
+			for (int i = 0; i < operand_count(op); i++) {
+				int operand = gate[g * GATE_SIZE + 1 + i] - inputs;
+				if (operand >= 0) {
+					gate_level = MAX(gate_level, level[operand] + 1);
+				}
+			}
+			level[g] = gate_level;
+			mark[g] = 2;
+			order.push_back(g);
+			stack.remove_at(stack.size() - 1);
+		}
+	}
+
+	//group gates level by level. Within a level order doesn't matter
+	int max_level = 0;
+	for (int g : order) {
+		max_level = MAX(max_level, level[g]);
+	}
+	LocalVector<int> levelized;
+	for (int l = 0; l <= max_level; l++) {
+		for (int g : order) {
+			if (level[g] == l) {
+				levelized.push_back(g);
+			}
+		}
+	}
+
+	if (inputs + (int)levelized.size() > MAX_NETS) {
+		r_error = vformat("logic block needs %d nets, more than the %d available.", inputs + levelized.size(), MAX_NETS);
+		return ERR_OUT_OF_MEMORY;
+	}
+
+	//inputs keep their nets, live gates are renumbered in sweep order
+	LocalVector<int> renumber;
+	renumber.resize(net_count);
+	for (int i = 0; i < inputs; i++) {
+		renumber[i] = i;
+	}
+	for (uint32_t i = 0; i < levelized.size(); i++) {
+		renumber[inputs + levelized[i]] = inputs + i;
+	}
+
+	Vector<float> program;
+	program.push_back(four_state ? 4.0f : 2.0f);
+	program.push_back((float)inputs);
+	program.push_back((float)outputs.size());
+	program.push_back((float)levelized.size());
+	for (int g : levelized) {
+		int op = gate[g * GATE_SIZE];
+		program.push_back((float)op);
+		for (int o = 0; o < GATE_SIZE - 1; o++) {
+			program.push_back(o < operand_count(op) ? (float)renumber[gate[g * GATE_SIZE + 1 + o]] : 0.0f);
+		}
+	}
+	for (int o = 0; o < outputs.size(); o++) {
+		program.push_back((float)renumber[outputs[o]]);
+	}
+
+	r_program = program;
+	return OK;
+}
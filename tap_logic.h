@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstdint>
+
+#include "core/error/error_list.h"
+#include "core/string/ustring.h"
+#include "core/templates/vector.h"
+
+/*
+Bit-parallel gate-level logic. A block of gates compiles once into a levelized
+list, so a single sweep in order evaluates every gate after its operands. Each
+net is a word of 64 independent lanes, so one instruction evaluates a gate
+for up to 64 input patterns at once.
+
+Two-state blocks keep one plane per net. Four-state blocks add a known plane,
+so X propagates the way a logic simulator would: a known 0 still forces an AND
+low, a known 1 still forces an OR high. Unknown lanes keep a value bit of 0.
+Nothing here drives Z, which would read as X at a gate input anyway.
+
+The compiled block is stored as floats in a component type's parameters, like
+the other compiled solvers:
+
+	state count (2 or 4), inputs, outputs, gate count,
+	gates as op, a, b, c...,
+	output nets...
+
+Nets are the inputs first, then one per gate in order. Every gate reads a, the
+binary ones b, and MUX picks b over a where its select c is high. Operands are
+masked into the net scratch, so a hand-edited block stays in bounds.
+*/
+struct tap_logic_t {
+	enum opcode_t {
+		OP_BUF,
+		OP_NOT,
+		OP_AND,
+		OP_OR,
+		OP_XOR,
+		OP_NAND,
+		OP_NOR,
+		OP_XNOR,
+		OP_MUX,
+		OP_MAX_OPCODE,
+	};
+
+	static constexpr int HEADER_SIZE = 4;
+	static constexpr int GATE_SIZE = 4;
+	//a power of two, so operands can be masked into range
+	static constexpr int MAX_NETS = 1024;
+
+	//pin levels in the digital domain. X sits below anything a gate drives
+	static constexpr float LOW_LEVEL = 0.0f;
+	static constexpr float HIGH_LEVEL = 1.0f;
+	static constexpr float UNKNOWN_LEVEL = -1.0f;
+
+	static inline int operand_count(int op) {
+		return op == OP_MUX ? 3 : (op <= OP_NOT ? 1 : 2);
+	}
+
+	/*
+	Levelize a gate list given as op, a, b, c per gate, with nets numbered as in
+	the compiled layout. Gates no output depends on are dropped. Fails on a
+	combinational loop or an out of range net, leaving `r_program` alone.
+	*/
+	static Error compile(int inputs, const Vector<int> &gates, const Vector<int> &outputs, bool four_state, Vector<float> &r_program, String &r_error);
+
+	static inline bool is_four_state(const float *program) {
+		return (int)program[0] == 4;
+	}
+
+	static inline int get_input_count(const float *program) {
+		return (int)program[1];
+	}
+
+	static inline int get_output_count(const float *program) {
+		return (int)program[2];
+	}
+
+	/*
+	Checks the header agrees with the program's size, in constant time. Enough
+	for the sweeps to stay in bounds.
+	*/
+	static inline bool is_valid(const float *program, int size) {
+		if (size < HEADER_SIZE) {
+			return false;
+		}
+		int states = (int)program[0];
+		int inputs = (int)program[1];
+		int outputs = (int)program[2];
+		int gates = (int)program[3];
+		if ((states != 2 && states != 4) || inputs < 0 || outputs < 0 || gates < 0 || inputs + gates > MAX_NETS) {
+			return false;
+		}
+		return size == HEADER_SIZE + gates * GATE_SIZE + outputs;
+	}
+
+	/*
+	Evaluate every gate of a valid two-state block. The first `inputs` words of
+	`value` must hold the inputs and `value` must have MAX_NETS words. Returns
+	the output nets, one per output.
+	*/
+	static inline const float *sweep_two_state(const float *program, uint64_t *value) {
+		int inputs = (int)program[1];
+		int gates = (int)program[3];
+
+		const float *code = program + HEADER_SIZE;
+		for (int g = 0; g < gates; g++, code += GATE_SIZE) {
+			uint64_t a = value[(int)code[1] & (MAX_NETS - 1)];
+			uint64_t b = value[(int)code[2] & (MAX_NETS - 1)];
+			uint64_t c = value[(int)code[3] & (MAX_NETS - 1)];
+
+			uint64_t result;
+			switch ((int)code[0]) {
+				case OP_BUF:
+					result = a;
+					break;
+				case OP_NOT:
+					result = ~a;
+					break;
+				case OP_AND:
+					result = a & b;
+					break;
+				case OP_OR:
+					result = a | b;
+					break;
+				case OP_XOR:
+					result = a ^ b;
+					break;
+				case OP_NAND:
+					result = ~(a & b);
+					break;
+				case OP_NOR:
+					result = ~(a | b);
+					break;
+				case OP_XNOR:
+					result = ~(a ^ b);
+					break;
+				case OP_MUX:
+					result = (a & ~c) | (b & c);
+					break;
+				default:
+					result = 0;
+					break;
+			}
+			value[inputs + g] = result;
+		}
+
+		return code;
+	}
+
+	/*
+	As `sweep_two_state`, with `known` set for every lane that isn't X. Value
+	bits of unknown input lanes must be 0.
+	*/
+	static inline const float *sweep_four_state(const float *program, uint64_t *value, uint64_t *known) {
+		int inputs = (int)program[1];
+		int gates = (int)program[3];
+
+		const float *code = program + HEADER_SIZE;
+		for (int g = 0; g < gates; g++, code += GATE_SIZE) {
+			int ia = (int)code[1] & (MAX_NETS - 1);
+			int ib = (int)code[2] & (MAX_NETS - 1);
+			int ic = (int)code[3] & (MAX_NETS - 1);
+			uint64_t va = value[ia], ka = known[ia];
+			uint64_t vb = value[ib], kb = known[ib];
+
+			//lanes known to be 1, and lanes known at all (value bits are only set where known)
+			uint64_t one, k;
+			switch ((int)code[0]) {
+				case OP_BUF:
+					k = ka;
+					one = va;
+					break;
+				case OP_NOT:
+					k = ka;
+					one = ka & ~va;
+					break;
+				case OP_AND:
+				case OP_NAND: {
+					uint64_t high = va & vb;
+					uint64_t low = (ka & ~va) | (kb & ~vb);
+					k = high | low;
+					one = (int)code[0] == OP_AND ? high : low;
+				} break;
+				case OP_OR:
+				case OP_NOR: {
+					uint64_t high = va | vb;
+					uint64_t low = (ka & ~va) & (kb & ~vb);
+					k = high | low;
+					one = (int)code[0] == OP_OR ? high : low;
+				} break;
+				case OP_XOR:
+					k = ka & kb;
+					one = (va ^ vb) & k;
+					break;
+				case OP_XNOR:
+					k = ka & kb;
+					one = ~(va ^ vb) & k;
+					break;
+				case OP_MUX: {
+					uint64_t vc = value[ic], kc = known[ic];
+					uint64_t pick_a = kc & ~vc;
+					uint64_t pick_b = vc;
+					//an unknown select still gives a known result where both sides agree
+					uint64_t agree = ~kc & ka & kb & ~(va ^ vb);
+					k = (pick_a & ka) | (pick_b & kb) | agree;
+					one = (pick_a & va) | (pick_b & vb) | (agree & va);
+				} break;
+				default:
+					k = ~(uint64_t)0;
+					one = 0;
+					break;
+			}
+			value[inputs + g] = one;
+			known[inputs + g] = k;
+		}
+
+		return code;
+	}
+};
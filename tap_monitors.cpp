@@ -0,0 +1,194 @@
+#include "core/object/callable_method_pointer.h"
+#include "core/os/os.h"
+#include "main/performance.h"
+
+#include "tap_component_type.h"
+#include "tap_monitors.h"
+
+std::atomic<uint64_t> TapMonitors::events_processed{ 0 };
+std::atomic<uint64_t> TapMonitors::solver_calls[TapMonitors::MAX_SOLVERS] = {};
+std::atomic<uint32_t> TapMonitors::queue_population{ 0 };
+std::atomic<uint32_t> TapMonitors::queue_peak{ 0 };
+std::atomic<int64_t> TapMonitors::simulation_lag{ 0 };
+std::atomic<uint64_t> TapMonitors::mix_usec{ 0 };
+std::atomic<uint64_t> TapMonitors::dropped_blocks{ 0 };
+
+tap_component_type_t::solver_t TapMonitors::solver_slots[TapMonitors::MAX_SOLVERS] = {};
+StringName TapMonitors::solver_names[TapMonitors::MAX_SOLVERS];
+int TapMonitors::solver_slot_count = 0;
+
+bool TapMonitors::registered = false;
+
+uint64_t TapMonitors::last_sample_usec = 0;
+uint64_t TapMonitors::last_events = 0;
+uint64_t TapMonitors::last_solver_calls[TapMonitors::MAX_SOLVERS] = {};
+uint64_t TapMonitors::last_solver_sample_usec[TapMonitors::MAX_SOLVERS] = {};
+
+uint64_t TapMonitors::counters_t::get_solver_call_total() const {
+	uint64_t total = 0;
+	for (uint64_t calls : solver_calls) {
+		total += calls;
+	}
+	return total;
+}
+
+int TapMonitors::get_solver_slot(tap_component_type_t::solver_t solver) {
+	for (int i = 0; i < solver_slot_count; i++) {
+		if (solver_slots[i] == solver) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void TapMonitors::flush_internal(const counters_t &counters, counters_t &r_published) {
+	//solver calls and queue changes only happen around events
+	if (counters.events == r_published.events) {
+		return;
+	}
+
+	events_processed.fetch_add(counters.events - r_published.events, std::memory_order_relaxed);
+	for (int i = 0; i < solver_slot_count; i++) {
+		if (counters.solver_calls[i] != r_published.solver_calls[i]) {
+			solver_calls[i].fetch_add(counters.solver_calls[i] - r_published.solver_calls[i], std::memory_order_relaxed);
+		}
+	}
+
+	queue_population.store(counters.queue_population, std::memory_order_relaxed);
+	uint32_t peak = queue_peak.load(std::memory_order_relaxed);
+	while (counters.queue_peak > peak && !queue_peak.compare_exchange_weak(peak, counters.queue_peak, std::memory_order_relaxed)) {
+	}
+
+	r_published = counters;
+}
+
+void TapMonitors::record_mix(uint64_t usec, int64_t lag) {
+	mix_usec.store(usec, std::memory_order_relaxed);
+	simulation_lag.store(lag, std::memory_order_relaxed);
+}
+
+void TapMonitors::record_dropped_block() {
+	dropped_blocks.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+Rates are taken over the time since the profiler last sampled the monitor.
+*/
+
+Variant TapMonitors::get_events_per_second() {
+	uint64_t now = OS::get_singleton()->get_ticks_usec();
+	uint64_t events = events_processed.load(std::memory_order_relaxed);
+
+	double rate = 0.0;
+	if (last_sample_usec != 0 && now > last_sample_usec) {
+		rate = (double)(events - last_events) * 1000000.0 / (double)(now - last_sample_usec);
+	}
+
+	last_sample_usec = now;
+	last_events = events;
+	return rate;
+}
+
+Variant TapMonitors::get_solver_calls_per_second(int slot) {
+	ERR_FAIL_INDEX_V(slot, solver_slot_count, 0.0);
+
+	uint64_t now = OS::get_singleton()->get_ticks_usec();
+	uint64_t calls = solver_calls[slot].load(std::memory_order_relaxed);
+
+	double rate = 0.0;
+	if (last_solver_sample_usec[slot] != 0 && now > last_solver_sample_usec[slot]) {
+		rate = (double)(calls - last_solver_calls[slot]) * 1000000.0 / (double)(now - last_solver_sample_usec[slot]);
+	}
+
+	last_solver_sample_usec[slot] = now;
+	last_solver_calls[slot] = calls;
+	return rate;
+}
+
+Variant TapMonitors::get_queue_population() {
+	return (int64_t)queue_population.load(std::memory_order_relaxed);
+}
+
+Variant TapMonitors::get_queue_peak() {
+	return (int64_t)queue_peak.load(std::memory_order_relaxed);
+}
+
+Variant TapMonitors::get_simulation_lag() {
+	return simulation_lag.load(std::memory_order_relaxed);
+}
+
+Variant TapMonitors::get_mix_usec() {
+	return (int64_t)mix_usec.load(std::memory_order_relaxed);
+}
+
+Variant TapMonitors::get_dropped_blocks() {
+	return (int64_t)dropped_blocks.load(std::memory_order_relaxed);
+}
+
+StringName TapMonitors::monitor_name(const String &name) {
+	return StringName("flex_logic/" + name);
+}
+
+PackedStringArray TapMonitors::get_monitor_names() {
+	PackedStringArray names;
+	names.push_back("events_per_second");
+	for (int i = 0; i < solver_slot_count; i++) {
+		names.push_back("solver_calls_per_second/" + String(solver_names[i]));
+	}
+	names.push_back("queue_population");
+	names.push_back("queue_peak");
+	names.push_back("simulation_lag_ticks");
+	names.push_back("mix_usec");
+	names.push_back("dropped_blocks");
+	return names;
+}
+
+void TapMonitors::register_monitors_internal() {
+	Performance *performance = Performance::get_singleton();
+	if (registered || !performance) {
+		return;
+	}
+
+	performance->add_custom_monitor(monitor_name("events_per_second"), callable_mp_static(&TapMonitors::get_events_per_second), Vector<Variant>());
+	for (int i = 0; i < solver_slot_count; i++) {
+		Vector<Variant> args;
+		args.push_back(i);
+		performance->add_custom_monitor(monitor_name("solver_calls_per_second/" + String(solver_names[i])), callable_mp_static(&TapMonitors::get_solver_calls_per_second), args);
+	}
+	performance->add_custom_monitor(monitor_name("queue_population"), callable_mp_static(&TapMonitors::get_queue_population), Vector<Variant>());
+	performance->add_custom_monitor(monitor_name("queue_peak"), callable_mp_static(&TapMonitors::get_queue_peak), Vector<Variant>());
+	performance->add_custom_monitor(monitor_name("simulation_lag_ticks"), callable_mp_static(&TapMonitors::get_simulation_lag), Vector<Variant>());
+	performance->add_custom_monitor(monitor_name("mix_usec"), callable_mp_static(&TapMonitors::get_mix_usec), Vector<Variant>());
+	performance->add_custom_monitor(monitor_name("dropped_blocks"), callable_mp_static(&TapMonitors::get_dropped_blocks), Vector<Variant>());
+	registered = true;
+}
+
+void TapMonitors::initialize_monitors_internal() {
+	solver_slot_count = 0;
+	for (const KeyValue<StringName, tap_component_type_t::solver_t> &entry : TapComponentType::solver_registry) {
+		if (solver_slot_count >= MAX_SOLVERS) {
+			WARN_PRINT("TapMonitors: too many solvers, the rest won't get a monitor.");
+			break;
+		}
+		solver_slots[solver_slot_count] = entry.value;
+		solver_names[solver_slot_count] = entry.key;
+		solver_slot_count++;
+	}
+
+	//Performance is only created after the modules, so wait for the main loop
+	callable_mp_static(&TapMonitors::register_monitors_internal).call_deferred();
+}
+
+void TapMonitors::uninitialize_monitors_internal() {
+	Performance *performance = Performance::get_singleton();
+	if (registered && performance) {
+		for (const String &name : get_monitor_names()) {
+			if (performance->has_custom_monitor(monitor_name(name))) {
+				performance->remove_custom_monitor(monitor_name(name));
+			}
+		}
+	}
+
+	registered = false;
+	solver_slot_count = 0;
+}
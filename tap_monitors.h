@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+
+#include "core/string/string_name.h"
+#include "core/variant/variant.h"
+
+#include "tap_circuit_types.h"
+
+/**
+ * @brief Custom Performance monitors for the circuit simulation.
+ *
+ * Counters are bumped on the audio thread without locks. Each circuit counts
+ * events and solver calls into its own `counters_t`, the same one behind
+ * `TapCircuit::get_stats`, and publishes what changed to relaxed atomics once
+ * per `process_to`/`mix`, so the per event cost is a plain add. Solver calls
+ * are counted by the slot cached on the component type when its solver is set.
+ * The monitors themselves are sampled on the main thread by the Godot
+ * profiler, which turns running totals into rates.
+ *
+ * Registered under "flex_logic/" once the main loop is running, since
+ * Performance doesn't exist yet when the module initializes:
+ * - events_per_second
+ * - solver_calls_per_second/<solver>, one per registered solver
+ * - queue_population, queue_peak
+ * - simulation_lag_ticks
+ * - mix_usec, wall time of the last mix block
+ * - dropped_blocks, blocks skipped because the circuit was locked
+ */
+class TapMonitors {
+public:
+	static constexpr int MAX_SOLVERS = 32;
+
+	/// @brief Running totals one circuit keeps while processing events
+	struct counters_t {
+		uint64_t events = 0;
+		//by solver slot, with solvers past MAX_SOLVERS counted in the last one
+		uint64_t solver_calls[MAX_SOLVERS + 1] = {};
+		uint32_t queue_population = 0;
+		uint32_t queue_peak = 0;
+
+		inline void count_solver_call(int slot) {
+			solver_calls[MIN((uint32_t)slot, (uint32_t)MAX_SOLVERS)]++;
+		}
+
+		inline void observe_queue(uint32_t population) {
+			queue_population = population;
+			if (population > queue_peak) {
+				queue_peak = population;
+			}
+		}
+
+		uint64_t get_solver_call_total() const;
+	};
+
+private:
+	static std::atomic<uint64_t> events_processed;
+	static std::atomic<uint64_t> solver_calls[MAX_SOLVERS];
+	static std::atomic<uint32_t> queue_population;
+	static std::atomic<uint32_t> queue_peak;
+	static std::atomic<int64_t> simulation_lag;
+	static std::atomic<uint64_t> mix_usec;
+	static std::atomic<uint64_t> dropped_blocks;
+
+	//solver function pointers by slot, filled once from the solver registry
+	static tap_component_type_t::solver_t solver_slots[MAX_SOLVERS];
+	static StringName solver_names[MAX_SOLVERS];
+	static int solver_slot_count;
+
+	//main thread only
+	static bool registered;
+
+	//main thread only, for turning totals into rates
+	static uint64_t last_sample_usec;
+	static uint64_t last_events;
+	static uint64_t last_solver_calls[MAX_SOLVERS];
+	static uint64_t last_solver_sample_usec[MAX_SOLVERS];
+
+	static StringName monitor_name(const String &name);
+	static PackedStringArray get_monitor_names();
+
+	/**
+	 * @brief Add the monitors to Performance, once. Deferred from
+	 * `initialize_monitors_internal`.
+	 */
+	static void register_monitors_internal();
+
+public:
+	/**
+	 * @brief Slot `solver`'s calls are counted in, or -1 if it isn't
+	 * registered. A scan, so resolve it once when the solver is set.
+	 */
+	static int get_solver_slot(tap_component_type_t::solver_t solver);
+
+	/**
+	 * @brief Publish what `counters` gained since `r_published`, then catch
+	 * `r_published` up. Call at the end of a batch of events, not per event.
+	 */
+	static void flush_internal(const counters_t &counters, counters_t &r_published);
+
+	static void record_mix(uint64_t usec, int64_t lag);
+	static void record_dropped_block();
+
+	static Variant get_events_per_second();
+	static Variant get_solver_calls_per_second(int slot);
+	static Variant get_queue_population();
+	static Variant get_queue_peak();
+	static Variant get_simulation_lag();
+	static Variant get_mix_usec();
+	static Variant get_dropped_blocks();
+
+	/**
+	 * @brief Assign solver slots and schedule the monitors to be added to
+	 * Performance. Call in "register_types.cpp" after the solver registry is
+	 * initialized.
+	 */
+	static void initialize_monitors_internal();
+
+	/**
+	 * @brief Remove whatever monitors were added. Call in "register_types.cpp"
+	 */
+	static void uninitialize_monitors_internal();
+};
@@ -149,6 +149,12 @@ tap_label_t TapNetwork::add_component(PackedInt64Array pin_labels, tap_label_t c
 		return components.INVALID_LABEL;
 	}
 
+	component.memory_offset = memory.size();
+	memory.resize(memory.size() + component.component_type.memory_size);
+	for (uint32_t i = component.memory_offset; i < memory.size(); i++) {
+		memory[i] = AudioFrame(0.0f, 0.0f);
+	}
+
 	tap_label_t label = components.label_add(component);
 
 	patch_bay->attach_pins_internal(component, label);
@@ -217,8 +223,41 @@ std::optional<tap_component_t> TapNetwork::get_component_internal(tap_label_t co
 	return components.label_get(component_label);
 }
 
+bool TapNetwork::is_self_scheduling_internal(tap_label_t component_label) const {
+	if (component_label >= (tap_label_t)components.size()) {
+		return false;
+	}
+	const std::optional<tap_component_t> &component = components[component_label];
+	return component.has_value() && component->component_type.self_scheduling;
+}
+
+Vector<tap_label_t> TapNetwork::get_self_scheduling_components_internal() const {
+	Vector<tap_label_t> labels;
+	for (tap_label_t i = 0; i < components.size(); i++) {
+		std::optional<tap_component_t> component = components.label_get(i);
+		if (component.has_value() && component->component_type.self_scheduling) {
+			labels.push_back(i);
+		}
+	}
+	return labels;
+}
+
+void TapNetwork::copy_components_from_internal(const TapNetwork &other) {
+	component_types = other.component_types;
+	wire_component_type = other.wire_component_type;
+	components = other.components;
+	memory = other.memory;
+}
+
+void TapNetwork::reset_memory_internal() {
+	for (AudioFrame &slot : memory) {
+		slot = AudioFrame(0.0f, 0.0f);
+	}
+}
+
 void TapNetwork::clear_components() {
 	components.clear();
+	memory.clear();
 }
 
 PackedInt64Array TapNetwork::get_component_connections(tap_label_t component_label) const {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/io/resource.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/vector.h"
 #include "core/variant/array.h"
 #include "core/variant/typed_array.h"
@@ -37,6 +38,13 @@ class TapNetwork : public Resource {
 
 	Labeling<tap_component_t> components;
 
+	/*
+	Memory for every stateful component, one contiguous arena. Each component
+	owns `component_type.memory_size` slots from its `memory_offset`. Removed
+	components leave their slots behind until the components are cleared.
+	*/
+	LocalVector<AudioFrame> memory;
+
 protected:
 	static void _bind_methods();
 
@@ -120,6 +128,36 @@ public:
 	 */
 	std::optional<tap_component_t> get_component_internal(tap_label_t component_label) const;
 
+	/**
+	 * @brief The component's memory in the arena, or nullptr if its type
+	 * keeps none. Only valid until the next component is added.
+	 */
+	inline AudioFrame *get_memory_internal(const tap_component_t &component) {
+		return component.component_type.memory_size > 0 ? memory.ptr() + component.memory_offset : nullptr;
+	}
+
+	/**
+	 * @brief Zero every component's memory, as if it was just added.
+	 */
+	void reset_memory_internal();
+
+	/**
+	 * @brief Whether the component's type schedules itself. Reads it in place,
+	 * without copying the component out.
+	 */
+	bool is_self_scheduling_internal(tap_label_t component_label) const;
+
+	/**
+	 * @brief Labels of every component whose type schedules itself.
+	 */
+	Vector<tap_label_t> get_self_scheduling_components_internal() const;
+
+	/**
+	 * @brief Copy component types and components from `other`. The patch bay
+	 * is left alone, so pins must be copied separately.
+	 */
+	void copy_components_from_internal(const TapNetwork &other);
+
 	/**
 	 * @brief Clear all components from this network
 	 */
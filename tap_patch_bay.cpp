@@ -39,15 +39,19 @@ void TapPatchBay::push_event(tap_time_t time, Vector2 state, tap_state_t pid) {
 }
 
 int TapPatchBay::get_event_count() const {
-	return queue.get_population();
+	int count = queue.get_population();
+	for (const input_lane_t &lane : input_lanes) {
+		count += lane.events.size() - lane.head;
+	}
+	return count;
 }
 
 Vector2 TapPatchBay::pop_next_state() {
-	if (queue.is_empty()) {
+	if (!has_next_event_internal()) {
 		return STATE_MISSING;
 	}
 
-	auto event = queue.pop_minimum().first;
+	tap_event_t event = pop_next_event_internal();
 	if (pins.label_get(event.pid).has_value()) {
 		AudioFrame state = event.state;
 		return Vector2(state.left, state.right);
@@ -57,13 +61,14 @@ Vector2 TapPatchBay::pop_next_state() {
 }
 
 std::optional<tap_event_t> TapPatchBay::get_next_event_internal() {
-	if (queue.is_empty()) {
+	if (!has_next_event_internal()) {
 		return std::nullopt;
 	}
 
-	auto pair = queue.minimum();
-	if (pins.label_get(pair.first.pid).has_value()) {
-		return pair.first;
+	int lane = find_next_lane_internal();
+	const tap_event_t &event = lane == QUEUE_LANE ? queue.minimum().first : input_lanes[lane].events[input_lanes[lane].head];
+	if (pins.label_get(event.pid).has_value()) {
+		return event;
 	}
 
 	return std::nullopt;
@@ -101,6 +106,109 @@ tap_queue_t &TapPatchBay::get_queue_internal() {
 	return queue;
 }
 
+void TapPatchBay::push_event_run_internal(tap_label_t pid, const tap_event_t *events, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	input_lane_t *lane = nullptr;
+	for (input_lane_t &candidate : input_lanes) {
+		if (candidate.pid == pid) {
+			lane = &candidate;
+			break;
+		}
+	}
+
+	if (!lane) {
+		input_lanes.push_back(input_lane_t{ pid, LocalVector<tap_event_t>(), 0 });
+		lane = &input_lanes[input_lanes.size() - 1];
+	}
+
+	//reclaim the consumed front of the lane before growing it
+	if (lane->is_empty()) {
+		lane->events.clear();
+		lane->head = 0;
+	} else if (lane->head >= lane->events.size() / 2) {
+		uint32_t remaining = lane->events.size() - lane->head;
+		for (uint32_t i = 0; i < remaining; i++) {
+			lane->events[i] = lane->events[lane->head + i];
+		}
+		lane->events.resize(remaining);
+		lane->head = 0;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		const tap_event_t &event = events[i];
+		if (!lane->is_empty() && event.time < lane->events[lane->events.size() - 1].time) {
+			queue.insert(event, event.time);
+			continue;
+		}
+		lane->events.push_back(event);
+	}
+}
+
+int TapPatchBay::find_next_lane_internal() {
+	int best = QUEUE_LANE;
+	tap_time_t best_time = 0;
+
+	//there are only ever a handful of inputs, so a linear scan of the lane heads
+	//beats keeping a second heap up to date
+	for (uint32_t i = 0; i < input_lanes.size(); i++) {
+		const input_lane_t &lane = input_lanes[i];
+		if (lane.is_empty()) {
+			continue;
+		}
+
+		tap_time_t time = lane.events[lane.head].time;
+		if (best == QUEUE_LANE || time < best_time) {
+			best = i;
+			best_time = time;
+		}
+	}
+
+	if (best != QUEUE_LANE && !queue.is_empty() && queue.minimum().first.time < best_time) {
+		return QUEUE_LANE;
+	}
+
+	return best;
+}
+
+bool TapPatchBay::has_next_event_internal() const {
+	if (!queue.is_empty()) {
+		return true;
+	}
+
+	for (const input_lane_t &lane : input_lanes) {
+		if (!lane.is_empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+tap_time_t TapPatchBay::get_next_time_internal() {
+	int lane = find_next_lane_internal();
+	if (lane == QUEUE_LANE) {
+		return queue.minimum().first.time;
+	}
+	return input_lanes[lane].events[input_lanes[lane].head].time;
+}
+
+tap_event_t TapPatchBay::pop_next_event_internal() {
+	int lane = find_next_lane_internal();
+	if (lane == QUEUE_LANE) {
+		return queue.pop_minimum().first;
+	}
+
+	input_lane_t &input_lane = input_lanes[lane];
+	return input_lane.events[input_lane.head++];
+}
+
+void TapPatchBay::clear_events_internal() {
+	queue.reset();
+	input_lanes.clear();
+}
+
 tap_label_t TapPatchBay::add_pin(Vector2 initial_state) {
 	AudioFrame frame(initial_state.x, initial_state.y);
 
@@ -110,9 +218,11 @@ tap_label_t TapPatchBay::add_pin(Vector2 initial_state) {
 
 	if (result >= pin_states.size()) {
 		pin_states.resize(result + 1);
+		initial_states.resize(result + 1);
 	}
 
 	pin_states.set(result, tap_event_t{ 0, frame, result, COMPONENT_MISSING });
+	initial_states.set(result, frame);
 
 	return result;
 }
@@ -126,6 +236,7 @@ bool TapPatchBay::remove_pin(tap_label_t label) {
 
 	if (result) {
 		pin_states.set(label, tap_event_t());
+		initial_states.set(label, AudioFrame(0, 0));
 	}
 
 	return result;
@@ -228,10 +339,30 @@ tap_event_t *TapPatchBay::get_state_internal(tap_label_t label) {
 	return &(pin_states.ptrw()[label]);
 }
 
+void TapPatchBay::copy_pins_from_internal(const TapPatchBay &other) {
+	tick_rate = other.tick_rate;
+	queue.reset();
+	input_lanes.clear();
+	pins = other.pins;
+	pin_states = other.pin_states;
+	initial_states = other.initial_states;
+}
+
+void TapPatchBay::reset_pin_states_internal() {
+	tap_event_t *states = pin_states.ptrw();
+	for (int i = 0; i < pin_states.size(); i++) {
+		if (pins.label_get(i)) {
+			states[i] = tap_event_t{ 0, initial_states[i], (tap_label_t)i, COMPONENT_MISSING };
+		}
+	}
+}
+
 void TapPatchBay::clear_pins() {
 	queue.reset();
+	input_lanes.clear();
 	pins.clear();
 	pin_states.clear();
+	initial_states.clear();
 }
 
 TypedDictionary<tap_label_t, PackedInt64Array> TapPatchBay::get_all_pin_connections() const {
@@ -3,6 +3,7 @@
 #include <optional>
 
 #include "core/io/resource.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/vector.h"
 #include "core/variant/typed_dictionary.h"
 #include "core/variant/variant.h"
@@ -29,11 +30,44 @@ class TapPatchBay : public Resource {
 	/// @brief Event queue
 	tap_queue_t queue;
 
+	/**
+	 * @brief A FIFO of events that arrived already sorted by time, like a
+	 * block of frames from one input stream.
+	 *
+	 * Lanes are merged with `queue` as events are popped, so a run of N input
+	 * events costs N appends instead of N heap inserts.
+	 */
+	struct input_lane_t {
+		tap_label_t pid;
+		LocalVector<tap_event_t> events;
+		uint32_t head = 0;
+
+		inline bool is_empty() const {
+			return head >= events.size();
+		}
+	};
+
+	/// @brief Input lanes, one per pid that has pushed a run
+	LocalVector<input_lane_t> input_lanes;
+
+	/// @brief Lane index returned by `find_next_lane_internal` for the queue
+	static constexpr int QUEUE_LANE = -1;
+
+	/**
+	 * @brief Find where the next event comes from: an input lane index, or
+	 * QUEUE_LANE. Ties go to input lanes.
+	 *
+	 * Assumes there is at least one event pending.
+	 */
+	int find_next_lane_internal();
+
 	/// @brief Pin mapping
 	Labeling<tap_pin_t> pins;
 
 	/// @brief State mapping (keep separate from optional pins for easier access)
 	Vector<tap_event_t> pin_states;
+	/// @brief The state each pin was added with, indexed like pin_states
+	Vector<AudioFrame> initial_states;
 
 protected:
 	static void _bind_methods();
@@ -60,6 +94,24 @@ public:
 
 	tap_queue_t &get_queue_internal();
 
+	/**
+	 * @brief Append a run of events for `pid` to its input lane.
+	 *
+	 * `events` must be sorted by time. Events that would land before the tail
+	 * of the lane fall back to the queue, so out of order runs are still
+	 * handled correctly, just without the speedup.
+	 */
+	void push_event_run_internal(tap_label_t pid, const tap_event_t *events, uint32_t count);
+
+	/// @brief True if either the queue or any input lane has an event pending
+	bool has_next_event_internal() const;
+	/// @brief Time of the earliest pending event. Assumes one is pending.
+	tap_time_t get_next_time_internal();
+	/// @brief Pop the earliest pending event across the queue and input lanes.
+	tap_event_t pop_next_event_internal();
+	/// @brief Drop every pending event. Pins keep their current states.
+	void clear_events_internal();
+
 	int get_sample_count() const;
 	void set_sample_count_internal(int new_samples);
 
@@ -88,6 +140,15 @@ public:
 	std::optional<tap_pin_t> get_pin_internal(tap_label_t label) const;
 	tap_event_t *get_state_internal(tap_label_t label);
 
+	/**
+	 * @brief Copy pins and their current states from `other`. Pending events
+	 * are not copied, the queue and lanes start empty.
+	 */
+	void copy_pins_from_internal(const TapPatchBay &other);
+
+	/// @brief Put every pin back to the state it was added with, at time 0.
+	void reset_pin_states_internal();
+
 	/**
 	 * @brief Clear all pins and their states from the patch bay.
 	 */
@@ -0,0 +1,66 @@
+#include "core/io/json.h"
+#include "core/variant/array.h"
+
+#include "tap_profiler.h"
+
+void tap_profiler_t::reset() {
+	components.clear();
+	invocations.clear();
+	queue_samples.clear();
+	next_sample_time = 0;
+	origin_nsec = now_nsec();
+}
+
+String tap_profiler_t::to_chrome_trace() const {
+	Array trace_events;
+
+	Dictionary process_name;
+	process_name["name"] = "process_name";
+	process_name["ph"] = "M";
+	process_name["pid"] = 1;
+	Dictionary process_args;
+	process_args["name"] = "TapCircuit";
+	process_name["args"] = process_args;
+	trace_events.push_back(process_name);
+
+	for (const invocation_t &invocation : invocations) {
+		const component_profile_t *profile = components.getptr(invocation.cid);
+		String type_name = profile ? String(profile->type_name) : String("?");
+
+		Dictionary event;
+		event["name"] = vformat("%s #%d", type_name, invocation.cid);
+		event["cat"] = type_name;
+		event["ph"] = "X";
+		//trace timestamps are in microseconds
+		event["ts"] = (double)invocation.start_nsec / 1000.0;
+		event["dur"] = (double)invocation.duration_nsec / 1000.0;
+		event["pid"] = 1;
+		event["tid"] = 1;
+
+		Dictionary args;
+		args["cid"] = invocation.cid;
+		args["simulated_time"] = invocation.time;
+		event["args"] = args;
+
+		trace_events.push_back(event);
+	}
+
+	for (const queue_sample_t &sample : queue_samples) {
+		Dictionary event;
+		event["name"] = "queue_depth";
+		event["ph"] = "C";
+		event["ts"] = (double)sample.wall_nsec / 1000.0;
+		event["pid"] = 1;
+
+		Dictionary args;
+		args["depth"] = sample.depth;
+		event["args"] = args;
+
+		trace_events.push_back(event);
+	}
+
+	Dictionary trace;
+	trace["traceEvents"] = trace_events;
+	trace["displayTimeUnit"] = "ns";
+	return JSON::stringify(trace);
+}
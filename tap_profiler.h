@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+
+#include "core/string/string_name.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+#include "core/variant/dictionary.h"
+
+#include "tap_circuit_types.h"
+
+/*
+Hot-spot profile of a TapCircuit, filled while the circuit's `profiling` flag
+is set.
+
+Solver calls are usually well under a microsecond, so they are timed with the
+steady clock in nanoseconds instead of `OS::get_ticks_usec`.
+*/
+struct tap_profiler_t {
+	struct component_profile_t {
+		StringName type_name;
+		uint64_t invocations = 0;
+		uint64_t events_emitted = 0;
+		uint64_t solver_nsec = 0;
+	};
+
+	//one solver call on the wall clock timeline, for the trace export
+	struct invocation_t {
+		uint64_t start_nsec;
+		uint64_t duration_nsec;
+		tap_time_t time;
+		tap_label_t cid;
+	};
+
+	struct queue_sample_t {
+		tap_time_t time;
+		uint64_t wall_nsec;
+		uint32_t depth;
+	};
+
+	//the timelines stop growing at these sizes, the totals keep counting
+	static constexpr uint32_t MAX_INVOCATIONS = 1 << 16;
+	static constexpr uint32_t MAX_QUEUE_SAMPLES = 1 << 16;
+
+	HashMap<tap_label_t, component_profile_t> components;
+	LocalVector<invocation_t> invocations;
+	LocalVector<queue_sample_t> queue_samples;
+
+	tap_time_t sample_interval = 1024;
+	tap_time_t next_sample_time = 0;
+	uint64_t origin_nsec = now_nsec();
+
+	static inline uint64_t now_nsec() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	inline void record_solve(tap_label_t cid, const StringName &type_name, tap_time_t time, uint64_t start_nsec, uint64_t end_nsec, uint32_t emitted) {
+		component_profile_t &profile = components[cid];
+		if (profile.invocations == 0) {
+			profile.type_name = type_name;
+		}
+		profile.invocations++;
+		profile.events_emitted += emitted;
+		profile.solver_nsec += end_nsec - start_nsec;
+
+		if (invocations.size() < MAX_INVOCATIONS) {
+			invocations.push_back(invocation_t{ start_nsec - origin_nsec, end_nsec - start_nsec, time, cid });
+		}
+	}
+
+	inline void sample_queue(tap_time_t time, uint32_t depth) {
+		if (time < next_sample_time || queue_samples.size() >= MAX_QUEUE_SAMPLES) {
+			return;
+		}
+		queue_samples.push_back(queue_sample_t{ time, now_nsec() - origin_nsec, depth });
+		next_sample_time = time + sample_interval;
+	}
+
+	void reset();
+
+	/*
+	Build the trace as Chrome trace event JSON, which Perfetto also reads.
+	Solver calls are complete events on one track, and queue depth is a counter
+	track.
+	*/
+	String to_chrome_trace() const;
+};
@@ -0,0 +1,174 @@
+#include "core/io/file_access.h"
+#include "core/math/math_funcs.h"
+#include "core/templates/hash_map.h"
+
+#include "tap_tracer.h"
+
+void tap_tracer_t::allocate(uint32_t capacity_bytes) {
+	chunk_count = MAX(capacity_bytes / CHUNK_SIZE, 1u);
+	buffer.resize(chunk_count * CHUNK_SIZE);
+	clear();
+}
+
+void tap_tracer_t::clear() {
+	chunk = 0;
+	offset = 0;
+	chunk_records = 0;
+	chunks_opened = 0;
+	records_written = 0;
+	previous_time = 0;
+	previous_pid = 0;
+}
+
+static uint64_t get_varint(const uint8_t *chunk_ptr, uint32_t &r_offset) {
+	uint64_t value = 0;
+	int shift = 0;
+	uint8_t byte;
+	do {
+		byte = chunk_ptr[r_offset++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+static uint64_t get_fixed(const uint8_t *chunk_ptr, uint32_t at, int bytes) {
+	uint64_t value = 0;
+	for (int i = 0; i < bytes; i++) {
+		value |= (uint64_t)chunk_ptr[at + i] << (8 * i);
+	}
+	return value;
+}
+
+LocalVector<tap_tracer_t::record_t> tap_tracer_t::decode() const {
+	LocalVector<record_t> records;
+	if (chunks_opened == 0) {
+		return records;
+	}
+
+	uint32_t live_chunks = (uint32_t)MIN(chunks_opened, (uint64_t)chunk_count);
+	uint32_t oldest = (chunk + chunk_count - (live_chunks - 1)) % chunk_count;
+
+	for (uint32_t i = 0; i < live_chunks; i++) {
+		const uint8_t *chunk_ptr = buffer.ptr() + (size_t)((oldest + i) % chunk_count) * CHUNK_SIZE;
+
+		uint32_t count = (uint32_t)get_fixed(chunk_ptr, 0, 4);
+		int64_t time = (int64_t)get_fixed(chunk_ptr, 4, 8);
+		int64_t pid = 0;
+		uint32_t at = CHUNK_HEADER_SIZE;
+
+		for (uint32_t r = 0; r < count; r++) {
+			time += unzigzag(get_varint(chunk_ptr, at));
+			pid += unzigzag(get_varint(chunk_ptr, at));
+			tap_label_t source_cid = (tap_label_t)(get_varint(chunk_ptr, at) - 1);
+			tap_frame state((tap_frame::bytes_t)get_fixed(chunk_ptr, at, 2), (tap_frame::bytes_t)get_fixed(chunk_ptr, at + 2, 2));
+			at += 4;
+
+			records.push_back(record_t{ (tap_time_t)time, (tap_label_t)pid, source_cid, state });
+		}
+	}
+
+	return records;
+}
+
+uint64_t tap_tracer_t::get_record_count() const {
+	if (chunks_opened == 0) {
+		return 0;
+	}
+
+	uint32_t live_chunks = (uint32_t)MIN(chunks_opened, (uint64_t)chunk_count);
+	uint32_t oldest = (chunk + chunk_count - (live_chunks - 1)) % chunk_count;
+
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < live_chunks; i++) {
+		count += get_fixed(buffer.ptr() + (size_t)((oldest + i) % chunk_count) * CHUNK_SIZE, 0, 4);
+	}
+	return count;
+}
+
+Error tap_tracer_t::save(const String &path) const {
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(file.is_null(), err, "tap_tracer_t::save: could not open " + path);
+
+	uint32_t live_chunks = (uint32_t)MIN(chunks_opened, (uint64_t)chunk_count);
+
+	//"TAPT", format version, chunk size, chunk count
+	file->store_buffer((const uint8_t *)"TAPT", 4);
+	file->store_32(1);
+	file->store_32(CHUNK_SIZE);
+	file->store_32(live_chunks);
+
+	if (live_chunks > 0) {
+		uint32_t oldest = (chunk + chunk_count - (live_chunks - 1)) % chunk_count;
+		for (uint32_t i = 0; i < live_chunks; i++) {
+			file->store_buffer(buffer.ptr() + (size_t)((oldest + i) % chunk_count) * CHUNK_SIZE, CHUNK_SIZE);
+		}
+	}
+
+	return OK;
+}
+
+//VCD identifiers are short strings of printable characters
+static String vcd_identifier(uint32_t index) {
+	String id;
+	do {
+		id += String::chr((char32_t)(33 + index % 94));
+		index /= 94;
+	} while (index > 0);
+	return id;
+}
+
+Error tap_tracer_t::export_vcd(const String &path, double ticks_per_second) const {
+	LocalVector<record_t> records = decode();
+
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(file.is_null(), err, "tap_tracer_t::export_vcd: could not open " + path);
+
+	//give every pin that shows up a pair of identifiers, in order of appearance
+	HashMap<tap_label_t, uint32_t> pin_ids;
+	LocalVector<tap_label_t> pins;
+	for (const record_t &record : records) {
+		if (!pin_ids.has(record.pid)) {
+			pin_ids.insert(record.pid, pins.size());
+			pins.push_back(record.pid);
+		}
+	}
+
+	//a tick is tens of picoseconds at usual rates, so count in femtoseconds
+	double units_per_tick = 1.0;
+	if (ticks_per_second > 0.0) {
+		units_per_tick = 1e15 / ticks_per_second;
+		file->store_string(vformat("$comment TapCircuit event trace at %s ticks per second $end\n", String::num(ticks_per_second, 0)));
+		file->store_string("$timescale 1 fs $end\n");
+	} else {
+		//VCD has no unit for a tick, so the ns here is nominal
+		file->store_string("$comment TapCircuit event trace, 1 unit = 1 simulated tick, not 1 ns $end\n");
+		file->store_string("$timescale 1 ns $end\n");
+	}
+	file->store_string("$scope module circuit $end\n");
+	for (uint32_t i = 0; i < pins.size(); i++) {
+		file->store_string(vformat("$var real 32 %s pin_%d_left $end\n", vcd_identifier(i * 2), pins[i]));
+		file->store_string(vformat("$var real 32 %s pin_%d_right $end\n", vcd_identifier(i * 2 + 1), pins[i]));
+	}
+	file->store_string("$upscope $end\n");
+	file->store_string("$enddefinitions $end\n");
+
+	bool first = true;
+	tap_time_t current_time = 0;
+	for (const record_t &record : records) {
+		if (first || record.time != current_time) {
+			current_time = record.time;
+			file->store_string("#" + itos((int64_t)Math::round((double)current_time * units_per_tick)) + "\n");
+			first = false;
+		}
+
+		AudioFrame state = AudioFrame(tap_frame::bytes_to_channel(record.state.left), tap_frame::bytes_to_channel(record.state.right));
+		uint32_t index = pin_ids[record.pid];
+		file->store_string(vformat("r%s %s\n", String::num(state.left, 6), vcd_identifier(index * 2)));
+		file->store_string(vformat("r%s %s\n", String::num(state.right, 6), vcd_identifier(index * 2 + 1)));
+	}
+
+	return OK;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "core/error/error_list.h"
+#include "core/string/ustring.h"
+#include "core/templates/local_vector.h"
+
+#include "tap_circuit_types.h"
+
+/*
+Bounded binary trace of every pin change a TapCircuit applies.
+
+The trace is a preallocated ring of fixed size chunks. Each chunk opens with a
+keyframe header, so it decodes without any earlier chunk. When the ring is full
+the oldest chunk is dropped whole. Inside a chunk, records are delta-encoded
+against the previous record:
+
+	varint zigzag(time - previous time)
+	varint zigzag(pid - previous pid)
+	varint (source cid + 1), so COMPONENT_MISSING is 0
+	2 x uint16 state as tap_frame bytes, little endian
+
+Chunk header: uint32 record count, uint64 keyframe time. The first record's
+deltas are taken against the keyframe time and pid 0.
+
+Recording never allocates, so the tracer can stay on during real-time playback.
+*/
+struct tap_tracer_t {
+	static constexpr uint32_t CHUNK_SIZE = 4096;
+	static constexpr uint32_t CHUNK_HEADER_SIZE = 12;
+	static constexpr uint32_t MAX_RECORD_SIZE = 10 + 5 + 5 + 4;
+
+	struct record_t {
+		tap_time_t time;
+		tap_label_t pid;
+		tap_label_t source_cid;
+		tap_frame state;
+	};
+
+	LocalVector<uint8_t> buffer;
+	uint32_t chunk_count = 0;
+	//chunk being written and the write offset inside it
+	uint32_t chunk = 0;
+	uint32_t offset = 0;
+	uint32_t chunk_records = 0;
+	//how many chunks have ever been opened, to find the oldest one left
+	uint64_t chunks_opened = 0;
+	uint64_t records_written = 0;
+
+	tap_time_t previous_time = 0;
+	tap_label_t previous_pid = 0;
+
+	/*
+	Allocate the ring, rounded down to whole chunks. Clears the trace.
+	*/
+	void allocate(uint32_t capacity_bytes);
+	void clear();
+
+	inline bool is_allocated() const {
+		return chunk_count > 0;
+	}
+
+	static inline uint64_t zigzag(int64_t value) {
+		return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+	}
+
+	static inline int64_t unzigzag(uint64_t value) {
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	inline void put_varint(uint8_t *chunk_ptr, uint64_t value) {
+		while (value >= 0x80) {
+			chunk_ptr[offset++] = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		chunk_ptr[offset++] = (uint8_t)value;
+	}
+
+	inline void put_fixed(uint8_t *chunk_ptr, uint32_t at, uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; i++) {
+			chunk_ptr[at + i] = (uint8_t)(value >> (8 * i));
+		}
+	}
+
+	inline void open_chunk(tap_time_t keyframe_time) {
+		if (chunks_opened > 0) {
+			chunk = (chunk + 1) % chunk_count;
+		}
+		chunks_opened++;
+
+		uint8_t *chunk_ptr = buffer.ptr() + (size_t)chunk * CHUNK_SIZE;
+		put_fixed(chunk_ptr, 0, 0, 4);
+		put_fixed(chunk_ptr, 4, (uint64_t)keyframe_time, 8);
+		offset = CHUNK_HEADER_SIZE;
+		chunk_records = 0;
+
+		previous_time = keyframe_time;
+		previous_pid = 0;
+	}
+
+	inline void record(const tap_event_t &event) {
+		if (chunks_opened == 0 || offset + MAX_RECORD_SIZE > CHUNK_SIZE) {
+			open_chunk(event.time);
+		}
+
+		uint8_t *chunk_ptr = buffer.ptr() + (size_t)chunk * CHUNK_SIZE;
+		tap_frame state(event.state);
+
+		put_varint(chunk_ptr, zigzag((int64_t)event.time - (int64_t)previous_time));
+		put_varint(chunk_ptr, zigzag((int64_t)event.pid - (int64_t)previous_pid));
+		put_varint(chunk_ptr, (uint64_t)(event.source_cid + 1));
+		put_fixed(chunk_ptr, offset, state.left, 2);
+		put_fixed(chunk_ptr, offset + 2, state.right, 2);
+		offset += 4;
+
+		chunk_records++;
+		put_fixed(chunk_ptr, 0, chunk_records, 4);
+
+		previous_time = event.time;
+		previous_pid = event.pid;
+		records_written++;
+	}
+
+	/*
+	Decode every record still in the ring, oldest first.
+	*/
+	LocalVector<record_t> decode() const;
+
+	/*
+	Records still in the ring. Older ones were dropped with their chunk.
+	*/
+	uint64_t get_record_count() const;
+
+	/*
+	Write the ring oldest chunk first, as the raw binary format above behind a
+	small file header.
+	*/
+	Error save(const String &path) const;
+
+	/*
+	Write the trace as a Value Change Dump. Each pin gets a real variable per
+	channel. Ticks are converted to femtoseconds at `ticks_per_second`, so
+	viewers show real time. With 0 the timescale is one nominal tick instead.
+	*/
+	Error export_vcd(const String &path, double ticks_per_second = 0.0) const;
+};
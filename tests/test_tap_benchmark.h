@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../tap_benchmark.h"
+#include "../tap_component_type.h"
+
+#include "tests/test_macros.h"
+
+/*
+Runs TapBenchmark under Godot's test runner, so a test build catches a broken
+case before anyone reads its numbers. Only compiled with `tests=yes`:
+
+	godot --test --test-case="*TapBenchmark*"
+
+Cases run small and short here. The timings aren't checked, only that every
+case builds, moves events and reports its metrics, and that every
+microbenchmark, one per registered solver included, reports a time.
+*/
+namespace TestTapBenchmark {
+
+static Ref<TapBenchmark> make_small_benchmark() {
+	Ref<TapBenchmark> benchmark;
+	benchmark.instantiate();
+	benchmark->set_scale(8);
+	benchmark->set_simulated_seconds(0.05);
+	return benchmark;
+}
+
+static void check_case_metrics(const Dictionary &result) {
+	CHECK(result.has("events"));
+	CHECK(result.has("solver_calls"));
+	CHECK(result.has("peak_memory"));
+	CHECK((int64_t)result["peak_memory"] >= 0);
+	CHECK((int64_t)result["events"] > 0);
+	CHECK((int64_t)result["wall_usec"] >= 0);
+	CHECK((double)result["ns_per_event"] >= 0.0);
+}
+
+TEST_CASE("[Modules][TapBenchmark][SceneTree] Every case runs through process_to") {
+	Ref<TapBenchmark> benchmark = make_small_benchmark();
+
+	for (const String &name : TapBenchmark::get_case_names()) {
+		INFO(name);
+		Dictionary result = benchmark->run_process_to_case(name);
+		CHECK(result["path"] == Variant("process_to"));
+		check_case_metrics(result);
+	}
+}
+
+TEST_CASE("[Modules][TapBenchmark][SceneTree][Audio] Every case runs through the mix path") {
+	Ref<TapBenchmark> benchmark = make_small_benchmark();
+
+	for (const String &name : TapBenchmark::get_case_names()) {
+		INFO(name);
+		Dictionary result = benchmark->run_mix_case(name);
+		CHECK(result["path"] == Variant("mix"));
+		check_case_metrics(result);
+	}
+}
+
+TEST_CASE("[Modules][TapBenchmark][SceneTree][Audio] Every microbenchmark reports a time") {
+	Ref<TapBenchmark> benchmark = make_small_benchmark();
+	benchmark->set_micro_iterations(100);
+	benchmark->set_micro_warmup(10);
+
+	Dictionary results = benchmark->run_microbenchmarks();
+
+	for (const KeyValue<StringName, tap_component_type_t::solver_t> &entry : TapComponentType::solver_registry) {
+		INFO(String(entry.key));
+		CHECK(results.has("solver_" + String(entry.key)));
+	}
+	for (const char *name : { "queue_input_runs", "queue_solver_delays", "queue_spread", "labeling_churn", "labeling_get", "tap_frame_from_audio", "tap_frame_to_audio", "tap_frame_delta", "primitive_mix_fast", "primitive_mix_reference" }) {
+		INFO(name);
+		CHECK(results.has(name));
+	}
+	for (const KeyValue<Variant, Variant> &kv : results) {
+		CHECK((double)kv.value >= 0.0);
+	}
+}
+
+} // namespace TestTapBenchmark